@@ -0,0 +1,127 @@
+/**
+ * Collisions and throughput of the hash functors for composite keys: the
+ * std::hash specializations hasher.hpp used to have, the current ones,
+ * and the FastHash policy.
+ *
+ *   ./hash_bench [num_keys]
+ */
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "hasher.hpp"
+
+using transformer::FastHash;
+
+namespace {
+
+// hasher.hpp's pair and array hashes before FastHash.
+struct LegacyPairHash {
+    size_t operator()(const std::pair<int, int>& value) const {
+        return std::hash<int>()(value.first) ^ std::hash<int>()(value.second);
+    }
+};
+
+struct LegacyArrayHash {
+    size_t operator()(const std::array<int, 4>& value) const {
+        size_t h = 0;
+        for (int x : value) {
+            h = h * 31 + std::hash<int>()(x);
+        }
+        return h;
+    }
+};
+
+template<typename Key, typename Hash>
+void run(const char* key_name, const char* hash_name,
+        const std::vector<Key>& keys) {
+    Hash hash;
+    std::unordered_set<size_t> full;
+    std::unordered_set<size_t> buckets;
+    // Power of two buckets, as hash tables reduce hashes to their low bits.
+    size_t mask = 1;
+    while (mask < keys.size()) {
+        mask <<= 1;
+    }
+    mask--;
+    for (const Key& key : keys) {
+        size_t h = hash(key);
+        full.insert(h);
+        buckets.insert(h & mask);
+    }
+
+    const int kRounds = 20;
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        for (const Key& key : keys) {
+            sink += hash(key);
+        }
+    }
+    double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    std::printf("%-22s %-10s %10zu %12zu %10.2f  (%zu)\n", key_name,
+            hash_name, keys.size() - full.size(), mask + 1 - buckets.size(),
+            seconds * 1e9 / (kRounds * keys.size()), sink & 1);
+}
+}
+
+int main(int argc, char** argv) {
+    size_t num_keys = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 18;
+    std::printf("%-22s %-10s %10s %12s %10s\n", "key", "hash", "collisions",
+            "empty slots", "ns/key");
+
+    // A grid of small ints, with the diagonal that xor sends to 0.
+    std::vector<std::pair<int, int>> pairs;
+    int side = 1;
+    while (static_cast<size_t>(side * side) < num_keys) {
+        side++;
+    }
+    for (int i = 0; i < side; i++) {
+        for (int j = 0; j < side; j++) {
+            pairs.emplace_back(i, j);
+        }
+    }
+    run<std::pair<int, int>, LegacyPairHash>("pair<int,int>", "legacy",
+            pairs);
+    run<std::pair<int, int>, std::hash<std::pair<int, int>>>(
+            "pair<int,int>", "std::hash", pairs);
+    run<std::pair<int, int>, FastHash<std::pair<int, int>>>(
+            "pair<int,int>", "FastHash", pairs);
+
+    std::vector<std::array<int, 4>> arrays;
+    for (size_t i = 0; i < num_keys; i++) {
+        arrays.push_back({{static_cast<int>(i % 7), static_cast<int>(i % 31),
+                static_cast<int>(i / 7 % 97), static_cast<int>(i / 217)}});
+    }
+    run<std::array<int, 4>, LegacyArrayHash>("array<int,4>", "legacy",
+            arrays);
+    run<std::array<int, 4>, std::hash<std::array<int, 4>>>("array<int,4>",
+            "std::hash", arrays);
+    run<std::array<int, 4>, FastHash<std::array<int, 4>>>("array<int,4>",
+            "FastHash", arrays);
+
+    typedef std::tuple<std::string, std::string> Names;
+    std::vector<Names> names;
+    for (size_t i = 0; i < num_keys; i++) {
+        names.emplace_back("first_" + std::to_string(i % 1000),
+                "last_name_" + std::to_string(i / 1000));
+    }
+    run<Names, std::hash<Names>>("tuple<string,string>", "std::hash", names);
+    run<Names, FastHash<Names>>("tuple<string,string>", "FastHash", names);
+
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < num_keys; i++) {
+        strings.push_back("user-" + std::to_string(i * 7919) + "@example.com");
+    }
+    run<std::string, std::hash<std::string>>("string", "std::hash", strings);
+    run<std::string, FastHash<std::string>>("string", "FastHash", strings);
+    return 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * Scratch memory for the temporaries of a transform: a bump allocator per
+ * thread, instead of the global heap, which many threads transforming at
+ * once contend on.
+ *
+ * A transformer opens an ArenaScope around the work on a row (or a batch),
+ * allocates its intermediates from it, e.g. in ArenaVectors, and everything
+ * is released at once when the scope closes. Scopes nest: a pipeline stage
+ * opening one inside another's only releases its own allocations. Blocks
+ * are kept for the next rows, so a warmed up thread doesn't allocate at
+ * all, up to ArenaScope::kMaxRetainedBytes: past it, the outermost scope
+ * frees the blocks a large batch left behind.
+ *
+ * Outputs, which outlive the transform, are allocated as usual.
+ */
+#ifndef FASTFEA_ARENA_H
+#define FASTFEA_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace transformer {
+
+class Arena {
+public:
+    explicit Arena(size_t block_size = 1 << 16) : _block_size(block_size) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        while (_block < _blocks.size()) {
+            Block& block = _blocks[_block];
+            size_t start = align(block.data.get() + _offset, alignment) -
+                block.data.get();
+            if (start + size <= block.size) {
+                _offset = start + size;
+                return block.data.get() + start;
+            }
+            _block++;
+            _offset = 0;
+        }
+        // Past the last block: a new one, large enough for this request.
+        Block block;
+        block.size = std::max(_block_size, size + alignment);
+        block.data.reset(new char[block.size]);
+        _blocks.push_back(std::move(block));
+        _block = _blocks.size() - 1;
+        _offset = 0;
+        return allocate(size, alignment);
+    }
+
+    struct Mark {
+        size_t block;
+        size_t offset;
+    };
+
+    /**
+     * The current position, to rewind to: what's allocated after it is
+     * released.
+     */
+    Mark mark() const {
+        return Mark{_block, _offset};
+    }
+
+    void rewind(const Mark& mark) {
+        _block = mark.block;
+        _offset = mark.offset;
+    }
+
+    /**
+     * Release everything, keeping the blocks.
+     */
+    void reset() {
+        _block = 0;
+        _offset = 0;
+    }
+
+    /**
+     * Free blocks past the current position, the last ones first, until at
+     * most max_bytes are held (or no free block is left).
+     */
+    void shrink(size_t max_bytes) {
+        size_t total = capacity();
+        // The current block is free too when nothing was allocated from it.
+        size_t first_free = _offset == 0 ? _block : _block + 1;
+        while (total > max_bytes && _blocks.size() > first_free) {
+            total -= _blocks.back().size;
+            _blocks.pop_back();
+        }
+    }
+
+    /**
+     * Bytes held in blocks.
+     */
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block& block : _blocks) {
+            total += block.size;
+        }
+        return total;
+    }
+
+private:
+    friend class ArenaScope;
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    static char* align(char* p, size_t alignment) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(p);
+        return p + (alignment - address % alignment) % alignment;
+    }
+
+    size_t _block_size;
+    std::vector<Block> _blocks;
+    size_t _block = 0;
+    size_t _offset = 0;
+    size_t _open_scopes = 0;
+};
+
+/**
+ * Standard allocator over an Arena, for containers of temporaries.
+ * Deallocating does nothing, the arena releases memory by rewinding.
+ */
+template<typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(Arena* arena) : _arena(arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other.arena()) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) {}
+
+    Arena* arena() const {
+        return _arena;
+    }
+
+private:
+    Arena* _arena;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena() == b.arena();
+}
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return !(a == b);
+}
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+/**
+ * The calling thread's scratch arena.
+ */
+inline Arena& scratch_arena() {
+    static thread_local Arena arena;
+    return arena;
+}
+
+/**
+ * Allocations from the thread's scratch arena, released when the scope
+ * closes. Containers using it must be declared after the scope.
+ */
+class ArenaScope {
+public:
+    /**
+     * Memory the thread's arena keeps once its outermost scope closes.
+     */
+    static const size_t kMaxRetainedBytes = 1 << 22;
+
+    ArenaScope() : _arena(scratch_arena()), _mark(_arena.mark()) {
+        _arena._open_scopes++;
+    }
+
+    ~ArenaScope() {
+        _arena.rewind(_mark);
+        if (--_arena._open_scopes == 0) {
+            _arena.shrink(kMaxRetainedBytes);
+        }
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    Arena& arena() {
+        return _arena;
+    }
+
+    /**
+     * An empty vector allocating from the scope.
+     */
+    template<typename T>
+    ArenaVector<T> vector() {
+        return ArenaVector<T>(ArenaAllocator<T>(&_arena));
+    }
+
+private:
+    Arena& _arena;
+    Arena::Mark _mark;
+};
+} // namespace: transformer
+
+#endif
@@ -0,0 +1,170 @@
+/**
+ * Bit-packed feature vector, for outputs that are all 0s and 1s (one-hot
+ * and multi-hot codes, indicators): a bit per dimension instead of a
+ * double, 64 times less memory, and counting common features is a popcount
+ * per 64 dimensions.
+ */
+#ifndef FASTFEA_BIT_VECTOR_H
+#define FASTFEA_BIT_VECTOR_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace transformer {
+
+/**
+ * Bit i is bit i % 64 of words()[i / 64]. Bits past size() in the last word
+ * are always 0.
+ */
+class BitVector {
+public:
+    BitVector() {}
+    explicit BitVector(size_t size) :
+            _size(size), _words((size + kWordBits - 1) / kWordBits) {}
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool test(size_t i) const {
+        return (_words[i / kWordBits] >> (i % kWordBits)) & 1;
+    }
+
+    bool operator[](size_t i) const {
+        return test(i);
+    }
+
+    void set(size_t i) {
+        _words[i / kWordBits] |= uint64_t(1) << (i % kWordBits);
+    }
+
+    void reset(size_t i) {
+        _words[i / kWordBits] &= ~(uint64_t(1) << (i % kWordBits));
+    }
+
+    /**
+     * Number of bits set.
+     */
+    size_t count() const {
+        size_t count = 0;
+        for (uint64_t word : _words) {
+            count += __builtin_popcountll(word);
+        }
+        return count;
+    }
+
+    /**
+     * Number of bits set in both, e.g. features two samples share.
+     */
+    size_t count_and(const BitVector& other) const {
+        if (other._size != _size) {
+            throw std::invalid_argument("BitVector: sizes differ");
+        }
+        size_t count = 0;
+        for (size_t i = 0; i < _words.size(); i++) {
+            count += __builtin_popcountll(_words[i] & other._words[i]);
+        }
+        return count;
+    }
+
+    const std::vector<uint64_t>& words() const {
+        return _words;
+    }
+
+    template<typename T = double>
+    std::vector<T> to_dense() const {
+        std::vector<T> dense(_size);
+        for (size_t i = 0; i < _size; i++) {
+            dense[i] = test(i);
+        }
+        return dense;
+    }
+
+    /**
+     * Append other's bits after this one's: whole words when size() is a
+     * multiple of 64, otherwise each word of other is shifted across two.
+     */
+    void append(const BitVector& other) {
+        if (&other == this) {
+            BitVector copy(other);
+            return append(copy);
+        }
+        size_t shift = _size % kWordBits;
+        _size += other._size;
+        if (shift == 0) {
+            _words.insert(_words.end(), other._words.begin(),
+                    other._words.end());
+            return;
+        }
+        for (uint64_t word : other._words) {
+            _words.back() |= word << shift;
+            _words.push_back(word >> (kWordBits - shift));
+        }
+        // The last shifted word may hold nothing but padding.
+        _words.resize((_size + kWordBits - 1) / kWordBits);
+    }
+
+    bool operator==(const BitVector& other) const {
+        return _size == other._size && _words == other._words;
+    }
+
+    bool operator!=(const BitVector& other) const {
+        return !(*this == other);
+    }
+
+private:
+    static const size_t kWordBits = 64;
+
+    size_t _size = 0;
+    std::vector<uint64_t> _words;
+};
+
+/**
+ * Like std::vector, two bit vectors combine into one, the second one's
+ * bits following the first one's.
+ */
+inline BitVector combine(BitVector&& first_out, BitVector&& second_out) {
+    BitVector out(std::move(first_out));
+    out.append(second_out);
+    return out;
+}
+
+/**
+ * Call func(index, 1.0) on the bits set, in index order.
+ */
+template<typename Func>
+void for_each_nonzero(const BitVector& vector, Func func) {
+    const std::vector<uint64_t>& words = vector.words();
+    for (size_t w = 0; w < words.size(); w++) {
+        for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+            func(w * 64 + __builtin_ctzll(word), 1.0);
+        }
+    }
+}
+
+/**
+ * Output vector of binarizers: std::vector<Value>, or a BitVector for
+ * bool.
+ */
+template<typename Value>
+struct BinaryVector {
+    typedef std::vector<Value> type;
+
+    static void set(type* vector, size_t i) {
+        (*vector)[i] = 1;
+    }
+};
+
+template<>
+struct BinaryVector<bool> {
+    typedef BitVector type;
+
+    static void set(type* vector, size_t i) {
+        vector->set(i);
+    }
+};
+} // namespace: transformer
+
+#endif
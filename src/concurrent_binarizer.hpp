@@ -0,0 +1,169 @@
+/**
+ * Binarizer whose step may be called from several threads at once.
+ */
+#ifndef FASTFEA_CONCURRENT_BINARIZER_H
+#define FASTFEA_CONCURRENT_BINARIZER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "transformer.hpp"
+
+namespace transformer {
+
+/**
+ * The vocabulary is split into shards by hash, each behind its own mutex, so
+ * threads stepping different values rarely wait for each other.
+ *
+ * Binarizer numbers the levels in order of first appearance, which is
+ * meaningless when several threads step at once. Instead every sample has a
+ * row number, each shard keeps the smallest row a level appeared at, and
+ * finalize numbers the levels by that row. When the row numbers are the
+ * positions in the dataset (e.g. each reader thread knows the offset of its
+ * chunk), the result is the same as fitting a Binarizer in a single thread,
+ * however the rows were spread across threads.
+ *
+ * transform is only valid after finalize.
+ */
+template<typename From, typename Value = FeatureValue,
+        template<typename> class Hash = FastHash>
+class ConcurrentBinarizer : public Binarizer<From, Value, Hash> {
+    typedef typename BinaryVector<Value>::type Output;
+
+public:
+    explicit ConcurrentBinarizer(size_t num_shards = 64) :
+            _shards(std::max<size_t>(num_shards, 1)) {}
+
+    /**
+     * Copies the levels seen so far, shard by shard, so it may run while
+     * other threads step.
+     */
+    ConcurrentBinarizer(const ConcurrentBinarizer& other) :
+            Binarizer<From, Value, Hash>(other),
+            _shards(other._shards.size()),
+            _next_row(other._next_row.load()) {
+        for (size_t i = 0; i < _shards.size(); i++) {
+            std::lock_guard<std::mutex> lock(other._shards[i].mutex);
+            _shards[i].first_row = other._shards[i].first_row;
+        }
+    }
+
+    /**
+     * Rows are numbered in call order. Deterministic only when called from
+     * a single thread.
+     */
+    virtual void step(const From& sample) {
+        step(sample, _next_row.fetch_add(1));
+    }
+
+    void step(const From& sample, uint64_t row) {
+        Shard& shard = shard_of(sample);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto result = shard.first_row.emplace(sample, row);
+        if (!result.second && row < result.first->second) {
+            result.first->second = row;
+        }
+    }
+
+    virtual void step_batch(const std::vector<From>& samples) {
+        step_batch(samples, _next_row.fetch_add(samples.size()));
+    }
+
+    /**
+     * Step samples[i] as row first_row + i. Each shard is locked once per
+     * batch rather than once per sample.
+     */
+    void step_batch(const std::vector<From>& samples, uint64_t first_row) {
+        std::vector<size_t> shard_ids(samples.size());
+        std::vector<size_t> order(samples.size());
+        for (size_t i = 0; i < samples.size(); i++) {
+            shard_ids[i] = shard_index(samples[i]);
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&shard_ids](size_t a, size_t b) {
+            return shard_ids[a] < shard_ids[b];
+        });
+        size_t begin = 0;
+        while (begin < order.size()) {
+            size_t shard_id = shard_ids[order[begin]];
+            size_t end = begin;
+            Shard& shard = _shards[shard_id];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (; end < order.size() && shard_ids[order[end]] == shard_id;
+                    end++) {
+                size_t i = order[end];
+                auto result = shard.first_row.emplace(samples[i],
+                        first_row + i);
+                if (!result.second && first_row + i < result.first->second) {
+                    result.first->second = first_row + i;
+                }
+            }
+            begin = end;
+        }
+    }
+
+    /**
+     * Must not run concurrently with step.
+     *
+     * After extend, only levels new since the last finalize are numbered,
+     * after the existing ones. Rows of the new samples should then come
+     * after the old ones for the result to match a single-threaded fit.
+     */
+    virtual void finalize() {
+        std::vector<std::pair<uint64_t, const From*>> levels;
+        for (const auto& shard : _shards) {
+            for (const auto& item : shard.first_row) {
+                if (this->_data_to_val.find(item.first) ==
+                        this->_data_to_val.end()) {
+                    levels.emplace_back(item.second, &item.first);
+                }
+            }
+        }
+        std::sort(levels.begin(), levels.end());
+        this->_data_to_val.reserve(this->_data_to_val.size() + levels.size());
+        for (const auto& level : levels) {
+            this->_data_to_val[*level.second] = this->_count++;
+        }
+        // The levels are all in _data_to_val now, don't hold them twice.
+        for (auto& shard : _shards) {
+            std::unordered_map<From, uint64_t, Hash<From>>().swap(
+                    shard.first_row);
+        }
+        this->_is_finalized = true;
+    }
+
+    virtual std::shared_ptr<Transformer<From, Output>> clone() const {
+        return std::make_shared<ConcurrentBinarizer>(*this);
+    }
+
+private:
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<From, uint64_t, Hash<From>> first_row;
+        // Keep mutexes of neighbouring shards off the same cache line.
+        char pad[64];
+    };
+
+    size_t shard_index(const From& sample) const {
+        // unordered_map buckets by the low bits of the same hash, pick the
+        // shard from the high bits so shards don't skew the buckets.
+        uint64_t hash = Hash<From>()(sample) * 0x9e3779b97f4a7c15ULL;
+        return (hash >> 32) % _shards.size();
+    }
+
+    Shard& shard_of(const From& sample) {
+        return _shards[shard_index(sample)];
+    }
+
+    std::vector<Shard> _shards;
+    std::atomic<uint64_t> _next_row{0};
+};
+} // namespace: transformer
+
+#endif
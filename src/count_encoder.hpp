@@ -0,0 +1,141 @@
+/**
+ * CountEncoder: replace a category by how often it was seen, for ids with
+ * too many levels to one-hot encode.
+ *
+ * step counts every level, exactly in a FlatHashMap, or in a CountMinSketch
+ * of fixed size (counts may then be a bit too high, never too low).
+ * Exact counts are encoded once, by finalize; a sketch is encoded at
+ * transform, from its smallest counter, so that its memory stays
+ * width * depth counters. A level never seen encodes as a count of 0.
+ * Shards fitted by different threads merge.
+ */
+#ifndef FASTFEA_COUNT_ENCODER_H
+#define FASTFEA_COUNT_ENCODER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "flat_map.hpp"
+#include "hasher.hpp"
+#include "sketch.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+template<typename From, template<typename> class Hash = FastHash>
+class CountEncoder : public Transformer<From, double> {
+public:
+    enum Output {
+        Raw,         // the count
+        Log,         // log(1 + count)
+        Normalized,  // count / number of samples
+    };
+
+    /**
+     * sketch_width and sketch_depth size the CountMinSketch of Sketch
+     * counting, and are ignored otherwise.
+     */
+    explicit CountEncoder(Output output = Raw,
+            Counting counting = Counting::Exact,
+            size_t sketch_width = 1 << 20, size_t sketch_depth = 4) :
+            _output(output), _counting(counting),
+            _sketch(counting == Counting::Sketch ? sketch_width : 1,
+                    counting == Counting::Sketch ? sketch_depth : 1) {
+        this->_is_finalized = false;
+    }
+
+    virtual void step(const From& sample) {
+        if (_counting == Counting::Exact) {
+            _exact[sample]++;
+        } else {
+            _sketch.add(Hash<From>()(sample));
+        }
+        _total++;
+    }
+
+    /**
+     * Fold in the counts of a CountEncoder fitted on other samples, with the
+     * same counting (and sketch size).
+     */
+    void merge(const CountEncoder& other) {
+        if (other._counting != _counting) {
+            throw std::invalid_argument(
+                    "CountEncoder: merging different countings");
+        }
+        if (_counting == Counting::Exact) {
+            other._exact.for_each([this](const From& level, uint64_t count) {
+                _exact[level] += count;
+            });
+        } else {
+            _sketch.merge(other._sketch);
+        }
+        _total += other._total;
+    }
+
+    virtual void finalize() {
+        _unseen = encode(0);
+        if (_counting == Counting::Exact) {
+            _exact_encoded.clear();
+            _exact_encoded.reserve(_exact.size());
+            _exact.for_each([this](const From& level, uint64_t count) {
+                _exact_encoded[level] = encode(count);
+            });
+        }
+        this->_is_finalized = true;
+    }
+
+    /**
+     * Further samples add to the counts, the next finalize encodes them
+     * again.
+     */
+    virtual void extend() {
+        this->_is_finalized = false;
+    }
+
+    virtual double transform(const From& sample) const {
+        if (_counting == Counting::Exact) {
+            const double* encoded = _exact_encoded.find(sample);
+            return encoded ? *encoded : _unseen;
+        }
+        return encode(_sketch.count(Hash<From>()(sample)));
+    }
+
+    virtual size_t output_dim() const {
+        return 1;
+    }
+
+    uint64_t total() const {
+        return _total;
+    }
+
+    virtual std::shared_ptr<Transformer<From, double>> clone() const {
+        return std::make_shared<CountEncoder>(*this);
+    }
+
+private:
+    double encode(uint64_t count) const {
+        switch (_output) {
+        case Log:
+            return std::log1p(static_cast<double>(count));
+        case Normalized:
+            return _total == 0 ? 0 : static_cast<double>(count) / _total;
+        default:
+            return static_cast<double>(count);
+        }
+    }
+
+    Output _output;
+    Counting _counting;
+    uint64_t _total = 0;
+    FlatHashMap<From, uint64_t, Hash<From>> _exact;
+    CountMinSketch _sketch;
+    FlatHashMap<From, double, Hash<From>> _exact_encoded;
+    double _unseen = 0;
+};
+} // namespace: transformer
+
+#endif
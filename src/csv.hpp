@@ -0,0 +1,353 @@
+/**
+ * CsvReader: read CSV/TSV files into rows of StringView fields, to feed
+ * transformers (step_batch, transform_batch) without copying the data.
+ *
+ * The file is memory-mapped and fields are views into the mapping, found
+ * with the SIMD byte scans of simd.hpp. The only field that can't be a view
+ * is a quoted one with escaped quotes ("a ""b"""), which is unescaped into
+ * storage of its row. Rows are reused from one batch to the next, so reading
+ * allocates next to nothing once the first batch is in.
+ *
+ * Quoting follows RFC 4180: a field starting with a quote runs until the
+ * next lone quote, delimiters and line breaks included, and "" stands for a
+ * quote. Lines end with \n, \r\n or \r; empty lines are skipped.
+ *
+ * Large files are parsed in parallel by for_each_batch: the file is cut into
+ * one chunk per thread at line breaks that are outside of quotes (found by
+ * counting quotes before each cut, which assumes quotes only appear in
+ * quoted fields).
+ */
+#ifndef FASTFEA_CSV_H
+#define FASTFEA_CSV_H
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "simd.hpp"
+#include "string_view.hpp"
+#include "thread_pool.hpp"
+
+namespace transformer {
+
+/**
+ * Fields of one row. Valid as long as the reader it came from.
+ */
+class CsvRow {
+public:
+    CsvRow() {}
+
+    CsvRow(const CsvRow& other) :
+            _fields(other._fields), _unescaped(other._unescaped),
+            _owned(other._owned) {
+        relink();
+    }
+
+    CsvRow(CsvRow&& other) noexcept :
+            _fields(std::move(other._fields)),
+            _unescaped(std::move(other._unescaped)),
+            _owned(std::move(other._owned)) {
+        relink();
+    }
+
+    CsvRow& operator=(CsvRow other) {
+        _fields.swap(other._fields);
+        _unescaped.swap(other._unescaped);
+        _owned.swap(other._owned);
+        relink();
+        return *this;
+    }
+
+    size_t size() const {
+        return _fields.size();
+    }
+
+    const StringView& operator[](size_t i) const {
+        return _fields[i];
+    }
+
+    const std::vector<StringView>& fields() const {
+        return _fields;
+    }
+
+    void clear() {
+        _fields.clear();
+        _unescaped.clear();
+        _owned.clear();
+    }
+
+    void add_field(StringView field) {
+        _fields.push_back(field);
+    }
+
+    /**
+     * Add a field held by the row itself.
+     */
+    void add_owned_field(const char* data, size_t size) {
+        Owned owned = {_fields.size(), _unescaped.size(), size};
+        _unescaped.append(data, size);
+        _owned.push_back(owned);
+        _fields.push_back(StringView());
+    }
+
+    /**
+     * Append to the last field added by add_owned_field.
+     */
+    void append_to_owned_field(const char* data, size_t size) {
+        _unescaped.append(data, size);
+        _owned.back().size += size;
+    }
+
+    /**
+     * Point owned fields at their characters, which move when _unescaped
+     * grows or the row is copied.
+     */
+    void relink() {
+        for (const Owned& owned : _owned) {
+            _fields[owned.field] = StringView(
+                    _unescaped.data() + owned.offset, owned.size);
+        }
+    }
+
+private:
+    struct Owned {
+        size_t field;
+        size_t offset;
+        size_t size;
+    };
+
+    std::vector<StringView> _fields;
+    std::string _unescaped;
+    std::vector<Owned> _owned;
+};
+
+class CsvReader {
+public:
+    /**
+     * With header, the first row names the columns and isn't read as data.
+     */
+    explicit CsvReader(const std::string& path, char delimiter = ',',
+            bool header = false) :
+            _file(new MappedFile(path)), _delimiter(delimiter) {
+        _begin = _file->data();
+        _end = _begin + _file->size();
+        _next = _begin;
+        if (header) {
+            CsvRow row;
+            if (read_row(&row)) {
+                for (const StringView& field : row.fields()) {
+                    _header.push_back(field.str());
+                }
+            }
+            _begin = _next;
+        }
+    }
+
+    const std::vector<std::string>& header() const {
+        return _header;
+    }
+
+    /**
+     * Index of the column with the given name in the header.
+     */
+    size_t column(const std::string& name) const {
+        for (size_t i = 0; i < _header.size(); i++) {
+            if (_header[i] == name) {
+                return i;
+            }
+        }
+        throw std::out_of_range("CsvReader: no column " + name);
+    }
+
+    /**
+     * Read the next row, false at the end of the file.
+     */
+    bool read_row(CsvRow* row) {
+        return parse_row(&_next, _end, row);
+    }
+
+    /**
+     * Read up to max_rows next rows into batch, reusing the storage of the
+     * rows already there. False when there was no row left.
+     */
+    bool read_batch(std::vector<CsvRow>* batch, size_t max_rows = 4096) {
+        return fill_batch(&_next, _end, batch, max_rows);
+    }
+
+    /**
+     * Parse the whole file (from the start, whatever was read already) in
+     * num_threads chunks in parallel, calling func(rows) with batches of up
+     * to batch_size rows. func is called from several threads at once: e.g.
+     * give each thread its own transformer to step and merge them in the
+     * end, or call transform_batch of a fitted one. Batches of a chunk come
+     * in order, chunks in no particular order.
+     */
+    template<typename Func>
+    void for_each_batch(size_t num_threads, size_t batch_size,
+            Func func) const {
+        std::vector<const char*> starts = chunk_starts(num_threads);
+        ThreadPool pool(starts.size() - 1);
+        std::vector<std::shared_ptr<Task>> tasks;
+        for (size_t i = 0; i + 1 < starts.size(); i++) {
+            const char* start = starts[i];
+            const char* stop = starts[i + 1];
+            tasks.push_back(pool.submit([this, start, stop, batch_size,
+                        &func]() {
+                const char* next = start;
+                std::vector<CsvRow> batch;
+                while (next < stop &&
+                        fill_batch(&next, stop, &batch, batch_size)) {
+                    func(static_cast<const std::vector<CsvRow>&>(batch));
+                }
+            }));
+        }
+        wait_all(tasks);
+    }
+
+private:
+    bool fill_batch(const char** next, const char* stop,
+            std::vector<CsvRow>* batch, size_t max_rows) const {
+        size_t count = 0;
+        while (count < max_rows && *next < stop) {
+            if (count == batch->size()) {
+                batch->emplace_back();
+            }
+            if (!parse_row(next, stop, &(*batch)[count])) {
+                break;
+            }
+            count++;
+        }
+        batch->resize(count);
+        return count > 0;
+    }
+
+    // Skip line breaks, then parse the row starting there, if before stop.
+    // The row itself may run past stop, up to the end of the file.
+    bool parse_row(const char** next, const char* stop, CsvRow* row) const {
+        const char* p = *next;
+        while (p < stop && (*p == '\n' || *p == '\r')) {
+            p++;
+        }
+        if (p >= stop) {
+            *next = p;
+            return false;
+        }
+        row->clear();
+        const char stops[] = {_delimiter, '\n', '\r'};
+        while (true) {
+            if (p < _end && *p == '"') {
+                p = parse_quoted(p + 1, row);
+                // Anything between the closing quote and the delimiter is
+                // dropped.
+                p += simd::find_first_of(p, _end - p, stops, 3);
+            } else {
+                size_t size = simd::find_first_of(p, _end - p, stops, 3);
+                row->add_field(StringView(p, size));
+                p += size;
+            }
+            if (p == _end) {
+                break;
+            }
+            if (*p == _delimiter) {
+                p++;
+                continue;
+            }
+            if (*p == '\r' && p + 1 < _end && p[1] == '\n') {
+                p++;
+            }
+            p++;
+            break;
+        }
+        row->relink();
+        *next = p;
+        return true;
+    }
+
+    // From right after the opening quote, to right after the closing one.
+    const char* parse_quoted(const char* p, CsvRow* row) const {
+        const char* start = p;
+        bool escaped = false;
+        while (true) {
+            const char* quote = p + simd::find_first_of(p, _end - p, "\"", 1);
+            if (quote + 1 < _end && quote[1] == '"') {
+                if (!escaped) {
+                    row->add_owned_field(start, quote + 1 - start);
+                    escaped = true;
+                } else {
+                    row->append_to_owned_field(p, quote + 1 - p);
+                }
+                p = quote + 2;
+                continue;
+            }
+            // Closing quote, or an unterminated field running to the end.
+            if (escaped) {
+                row->append_to_owned_field(p, quote - p);
+            } else {
+                row->add_field(StringView(start, quote - start));
+            }
+            return quote < _end ? quote + 1 : _end;
+        }
+    }
+
+    // Chunk i is [starts[i], starts[i + 1]): rows starting there.
+    std::vector<const char*> chunk_starts(size_t num_chunks) const {
+        size_t size = _end - _begin;
+        num_chunks = std::max<size_t>(1, std::min(num_chunks,
+                    size / kMinChunkSize));
+        // Quotes before each cut, counted in parallel.
+        std::vector<size_t> quotes(num_chunks);
+        {
+            ThreadPool pool(num_chunks);
+            std::vector<std::shared_ptr<Task>> tasks;
+            for (size_t i = 0; i < num_chunks; i++) {
+                tasks.push_back(pool.submit([this, i, num_chunks, size,
+                            &quotes]() {
+                    const char* from = _begin + size * i / num_chunks;
+                    const char* to = _begin + size * (i + 1) / num_chunks;
+                    quotes[i] = simd::count_byte(from, to - from, '"');
+                }));
+            }
+            wait_all(tasks);
+        }
+        std::vector<const char*> starts(1, _begin);
+        size_t quotes_before = 0;
+        for (size_t i = 1; i < num_chunks; i++) {
+            quotes_before += quotes[i - 1];
+            const char* cut = _begin + size * i / num_chunks;
+            // Move the cut past the next line break outside of quotes,
+            // starting from the byte before it, which may be a line break
+            // itself.
+            const char* p = cut - 1;
+            bool quoted = (quotes_before - (*p == '"')) % 2 == 1;
+            for (; p < _end; p++) {
+                if (*p == '"') {
+                    quoted = !quoted;
+                } else if (!quoted && (*p == '\n' || *p == '\r')) {
+                    break;
+                }
+            }
+            if (p < _end && *p == '\r' && p + 1 < _end && p[1] == '\n') {
+                p++;
+            }
+            p = std::min(p + 1, _end);
+            starts.push_back(std::max(p, starts.back()));
+        }
+        starts.push_back(_end);
+        return starts;
+    }
+
+    static const size_t kMinChunkSize = 1 << 16;
+
+    std::shared_ptr<MappedFile> _file;
+    char _delimiter;
+    const char* _begin;
+    const char* _end;
+    const char* _next;
+    std::vector<std::string> _header;
+};
+} // namespace: transformer
+
+#endif
@@ -0,0 +1,230 @@
+/**
+ * DenseMatrixWriter: a dense row-major matrix of float32 (or float64)
+ * written in place into a memory-mapped file, either a NumPy .npy file
+ * (numpy.load(path, mmap_mode='r')) or the raw array
+ * (numpy.fromfile(path, numpy.float32).reshape(num_rows, num_cols)).
+ *
+ * The file is sized up front from the number of rows and columns (e.g.
+ * output_dim() of a finalized transformer), so row i has a known place:
+ * transform_into has several threads transform disjoint ranges of samples
+ * and store their rows directly, nothing is formatted nor parsed again.
+ */
+#ifndef FASTFEA_DENSE_WRITER_H
+#define FASTFEA_DENSE_WRITER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "bit_vector.hpp"
+#include "mapped_file.hpp"
+#include "segments.hpp"
+#include "sparse.hpp"
+#include "thread_pool.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+template<typename T = float>
+class DenseMatrixWriter {
+    static_assert(std::is_same<T, float>::value ||
+            std::is_same<T, double>::value,
+            "DenseMatrixWriter: T is float or double");
+
+public:
+    enum Format {
+        Npy,  // NumPy .npy, version 1.0
+        Raw,  // the array alone
+    };
+
+    DenseMatrixWriter(const std::string& path, size_t num_rows,
+            size_t num_cols, Format format = Npy) :
+            _num_rows(num_rows), _num_cols(num_cols) {
+        std::string header = format == Npy ? npy_header() : std::string();
+        _file.reset(new MappedOutputFile(path,
+                    header.size() + num_rows * num_cols * sizeof(T)));
+        if (!header.empty()) {
+            std::memcpy(_file->data(), header.data(), header.size());
+        }
+        _data = reinterpret_cast<T*>(_file->data() + header.size());
+    }
+
+    size_t num_rows() const {
+        return _num_rows;
+    }
+
+    size_t num_cols() const {
+        return _num_cols;
+    }
+
+    /**
+     * num_cols values, zeros until written. Different threads may fill
+     * different rows.
+     */
+    T* row(size_t i) {
+        return _data + i * _num_cols;
+    }
+
+    template<typename U>
+    void write_row(size_t i, const std::vector<U>& values) {
+        check_row(i);
+        if (values.size() != _num_cols) {
+            throw std::invalid_argument("DenseMatrixWriter: row size differs");
+        }
+        T* out = row(i);
+        for (size_t j = 0; j < _num_cols; j++) {
+            out[j] = static_cast<T>(values[j]);
+        }
+    }
+
+    /**
+     * Each element is copied once, from its segment into the row.
+     */
+    template<typename U>
+    void write_row(size_t i, const Segments<U>& values) {
+        check_row(i);
+        if (values.size() != _num_cols) {
+            throw std::invalid_argument("DenseMatrixWriter: row size differs");
+        }
+        values.gather(row(i));
+    }
+
+    template<typename U>
+    void write_row(size_t i, const SparseVector<U>& values) {
+        check_row(i);
+        if (values.dim != _num_cols) {
+            throw std::invalid_argument("DenseMatrixWriter: row size differs");
+        }
+        T* out = row(i);
+        std::fill(out, out + _num_cols, T(0));
+        for (size_t k = 0; k < values.nnz(); k++) {
+            out[values.indices[k]] = static_cast<T>(values.values[k]);
+        }
+    }
+
+    void write_row(size_t i, const BitVector& values) {
+        check_row(i);
+        if (values.size() != _num_cols) {
+            throw std::invalid_argument("DenseMatrixWriter: row size differs");
+        }
+        T* out = row(i);
+        std::fill(out, out + _num_cols, T(0));
+        for_each_nonzero(values, [out](size_t j, double) {
+            out[j] = 1;
+        });
+    }
+
+    /**
+     * A scalar, for a matrix of one column.
+     */
+    void write_row(size_t i, double value) {
+        check_row(i);
+        if (_num_cols != 1) {
+            throw std::invalid_argument("DenseMatrixWriter: row size differs");
+        }
+        *row(i) = static_cast<T>(value);
+    }
+
+    /**
+     * Transform samples into rows [first_row, first_row + samples.size()),
+     * with num_threads threads each taking a contiguous range of them, in
+     * batches of kBatchSize. A batch is a slice of samples, transformed
+     * where it is (see Transformer::transform_batch), not a copy.
+     */
+    template<typename From, typename To>
+    void transform_into(const Transformer<From, To>& transformer,
+            const std::vector<From>& samples, size_t first_row = 0,
+            size_t num_threads = 1) {
+        size_t dim = transformer.output_dim();
+        if (dim != 0 && dim != _num_cols) {
+            throw std::invalid_argument(
+                    "DenseMatrixWriter: transformer output size differs");
+        }
+        if (first_row > _num_rows || samples.size() > _num_rows - first_row) {
+            throw std::invalid_argument("DenseMatrixWriter: too many rows");
+        }
+        size_t num_ranges = std::max<size_t>(1,
+                std::min(num_threads, samples.size()));
+        if (num_ranges == 1) {
+            transform_range(transformer, samples, 0, samples.size(),
+                    first_row);
+            return;
+        }
+        ThreadPool pool(num_ranges);
+        std::vector<std::shared_ptr<Task>> tasks;
+        for (size_t r = 0; r < num_ranges; r++) {
+            size_t start = samples.size() * r / num_ranges;
+            size_t stop = samples.size() * (r + 1) / num_ranges;
+            tasks.push_back(pool.submit([&, start, stop]() {
+                transform_range(transformer, samples, start, stop,
+                        first_row);
+            }));
+        }
+        wait_all(tasks);
+    }
+
+    /**
+     * Write the matrix back to the file: rows not written are zeros.
+     */
+    void close() {
+        _file->close();
+    }
+
+private:
+    static const size_t kBatchSize = 1024;
+
+    std::string npy_header() const {
+        char dict[256];
+        int length = std::snprintf(dict, sizeof(dict),
+                "{'descr': '<f%u', 'fortran_order': False, "
+                "'shape': (%llu, %llu), }",
+                static_cast<unsigned>(sizeof(T)),
+                static_cast<unsigned long long>(_num_rows),
+                static_cast<unsigned long long>(_num_cols));
+        // Magic, version 1.0, the uint16 length of the dict, then the dict
+        // padded with spaces and a newline so that data is 64-byte aligned.
+        std::string header("\x93NUMPY\x01\x00\x00\x00", 10);
+        header.append(dict, length);
+        size_t size = (header.size() + 1 + 63) / 64 * 64;
+        header.append(size - 1 - header.size(), ' ');
+        header.push_back('\n');
+        uint16_t dict_size = static_cast<uint16_t>(size - 10);
+        header[8] = static_cast<char>(dict_size & 0xff);
+        header[9] = static_cast<char>(dict_size >> 8);
+        return header;
+    }
+
+    void check_row(size_t i) const {
+        if (i >= _num_rows) {
+            throw std::invalid_argument("DenseMatrixWriter: no such row");
+        }
+    }
+
+    template<typename From, typename To>
+    void transform_range(const Transformer<From, To>& transformer,
+            const std::vector<From>& samples, size_t start, size_t stop,
+            size_t first_row) {
+        for (size_t i = start; i < stop; i += kBatchSize) {
+            size_t n = std::min<size_t>(stop - i, +kBatchSize);
+            std::vector<To> rows = transformer.transform_batch(
+                    samples.data() + i, n);
+            for (size_t k = 0; k < n; k++) {
+                write_row(first_row + i + k, rows[k]);
+            }
+        }
+    }
+
+    size_t _num_rows;
+    size_t _num_cols;
+    std::unique_ptr<MappedOutputFile> _file;
+    T* _data = nullptr;
+};
+} // namespace: transformer
+
+#endif
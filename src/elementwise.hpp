@@ -0,0 +1,210 @@
+/**
+ * Element-wise numeric transformers, and fusion of chains of them.
+ *
+ * A pipeline such as log1p + standardizer + clip transforms a batch in three
+ * passes, each reading the whole column and writing a new one. Once every
+ * stage is fitted, Pipeline asks its stages to fuse (see Transformer::fuse):
+ * element-wise stages make a single FusedElementwise, which runs all of them
+ * on a block small enough to stay in L1 before moving to the next block, so
+ * the batch is read once and written once. Consecutive affine stages
+ * (scalers) are folded into one multiply-add on top of that.
+ */
+#ifndef FASTFEA_ELEMENTWISE_H
+#define FASTFEA_ELEMENTWISE_H
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "simd.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+/**
+ * A transformer computing each output value from the input value at the
+ * same position, and nothing else, through apply, its in-place kernel over
+ * an array. T is double or float: float transformers run float kernels,
+ * and their output stays float.
+ *
+ * Must be owned by a shared_ptr to be fused.
+ */
+template<typename T = FeatureValue>
+class ElementwiseTransformer :
+        public Transformer<T, T>,
+        public std::enable_shared_from_this<ElementwiseTransformer<T>> {
+    static_assert(std::is_same<T, double>::value ||
+            std::is_same<T, float>::value,
+            "ElementwiseTransformer: double or float");
+
+public:
+    /**
+     * Transform data[0, n) in place.
+     */
+    virtual void apply(T* data, size_t n) const = 0;
+
+    /**
+     * Whether the transform is x * scale + shift, and if so with which
+     * scale and shift.
+     */
+    virtual bool affine(T* scale, T* shift) const {
+        return false;
+    }
+
+    virtual T transform(const T& sample) const {
+        T output = sample;
+        apply(&output, 1);
+        return output;
+    }
+
+    using Transformer<T, T>::transform_batch;
+
+    /**
+     * Copy a block, transform it while it's hot, move on to the next one.
+     */
+    virtual std::vector<T> transform_batch(const T* first, size_t n) const {
+        std::vector<T> output;
+        output.reserve(n);
+        for (size_t i = 0; i < n; i += kBlockSize) {
+            size_t size = std::min<size_t>(n - i, +kBlockSize);
+            output.insert(output.end(), first + i, first + i + size);
+            apply(output.data() + i, size);
+        }
+        return output;
+    }
+
+    /**
+     * The batch is transformed where it is.
+     */
+    virtual std::vector<T> transform_batch(std::vector<T>&& samples) {
+        apply(samples.data(), samples.size());
+        return std::move(samples);
+    }
+
+    virtual size_t output_dim() const {
+        return 1;
+    }
+
+    virtual std::shared_ptr<Transformer<T, T>> fuse(
+            const std::shared_ptr<Transformer<T, T>>& next) const;
+
+protected:
+    typedef std::vector<std::shared_ptr<const ElementwiseTransformer>> Stages;
+
+    // 4KB, leaves room in L1 for the other operand of a kernel.
+    static const size_t kBlockSize = 4096 / sizeof(T);
+
+    /**
+     * Append the transformers this one runs, in order.
+     */
+    virtual void append_stages(Stages* stages) const {
+        stages->push_back(this->shared_from_this());
+    }
+};
+
+/**
+ * A chain of element-wise transformers, run as one.
+ *
+ * Scales and shifts of affine stages are read at construction, i.e. fusing
+ * is meant for fitted stages. Folding two affine stages into one may change
+ * the last bits of the result.
+ */
+template<typename T = FeatureValue>
+class FusedElementwise : public ElementwiseTransformer<T> {
+    typedef typename ElementwiseTransformer<T>::Stages Stages;
+    using ElementwiseTransformer<T>::kBlockSize;
+
+public:
+    explicit FusedElementwise(const Stages& stages) : _stages(stages) {
+        for (const auto& stage : stages) {
+            Op op;
+            op.is_affine = stage->affine(&op.scale, &op.shift);
+            if (op.is_affine && !_ops.empty() && _ops.back().is_affine) {
+                // (x * a1 + b1) * a2 + b2
+                Op& last = _ops.back();
+                last.scale *= op.scale;
+                last.shift = last.shift * op.scale + op.shift;
+                continue;
+            }
+            op.stage = stage;
+            _ops.push_back(op);
+        }
+    }
+
+    virtual void apply(T* data, size_t n) const {
+        for (size_t i = 0; i < n; i += kBlockSize) {
+            size_t size = std::min<size_t>(n - i, +kBlockSize);
+            for (const Op& op : _ops) {
+                if (op.is_affine) {
+                    simd::affine(data + i, data + i, size, op.scale,
+                            op.shift);
+                } else {
+                    op.stage->apply(data + i, size);
+                }
+            }
+        }
+    }
+
+    virtual bool affine(T* scale, T* shift) const {
+        if (_ops.size() != 1 || !_ops[0].is_affine) {
+            return false;
+        }
+        *scale = _ops[0].scale;
+        *shift = _ops[0].shift;
+        return true;
+    }
+
+    /**
+     * Number of passes over each block, after folding affine stages.
+     */
+    size_t num_ops() const {
+        return _ops.size();
+    }
+
+    /**
+     * The clone runs clones of the stages.
+     */
+    virtual std::shared_ptr<Transformer<T, T>> clone() const {
+        Stages stages;
+        for (const auto& stage : _stages) {
+            stages.push_back(std::static_pointer_cast<
+                    ElementwiseTransformer<T>>(stage->clone()));
+        }
+        return std::make_shared<FusedElementwise>(stages);
+    }
+
+protected:
+    virtual void append_stages(Stages* stages) const {
+        stages->insert(stages->end(), _stages.begin(), _stages.end());
+    }
+
+private:
+    struct Op {
+        std::shared_ptr<const ElementwiseTransformer<T>> stage;
+        bool is_affine = false;
+        T scale = 1;
+        T shift = 0;
+    };
+
+    Stages _stages;
+    std::vector<Op> _ops;
+};
+
+template<typename T>
+std::shared_ptr<Transformer<T, T>> ElementwiseTransformer<T>::fuse(
+        const std::shared_ptr<Transformer<T, T>>& next) const {
+    auto elementwise =
+        std::dynamic_pointer_cast<ElementwiseTransformer>(next);
+    if (!elementwise || !this->is_finalized() ||
+            !elementwise->is_finalized()) {
+        return nullptr;
+    }
+    Stages stages;
+    append_stages(&stages);
+    elementwise->append_stages(&stages);
+    return std::make_shared<FusedElementwise<T>>(stages);
+}
+} // namespace: transformer
+
+#endif
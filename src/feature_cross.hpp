@@ -0,0 +1,171 @@
+/**
+ * FeatureCross: hashed interactions of categorical features.
+ *
+ * Binarizing a tuple of N columns learns one level per combination seen, so
+ * the dictionary (and the output) grows with the product of the columns'
+ * cardinalities. FeatureCross hashes each combination straight to one of a
+ * fixed number of buckets instead: nothing to fit, and memory doesn't depend
+ * on the data, at the price of the occasional collision.
+ *
+ * The input is one value, or a tuple of them (e.g. the output of
+ * (A | B | C)). Each value contributes weighted terms to the cross:
+ * - a categorical value (anything the hash policy hashes) is one term of
+ *   weight 1,
+ * - a SparseVector (QuantileBinner, FeatureCross itself) has one term per
+ *   non-zero, the index hashed, the value as weight,
+ * - a numeric std::vector or BitVector (Binarizer) likewise, for its
+ *   non-zeros.
+ * The output has one entry per combination of terms, one from each value,
+ * weighing the product of their weights. Entries falling in the same bucket
+ * are summed.
+ */
+#ifndef FASTFEA_FEATURE_CROSS_H
+#define FASTFEA_FEATURE_CROSS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "bit_vector.hpp"
+#include "hasher.hpp"
+#include "sparse.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+namespace cross_detail {
+
+typedef std::pair<uint64_t, double> Term;
+// Terms only live during a transform, in its scratch arena.
+typedef ArenaVector<Term> Terms;
+
+// Cross every term so far with every term of value.
+inline void cross(const Terms& terms, uint64_t hash, double weight,
+        Terms* output) {
+    for (const Term& term : terms) {
+        output->emplace_back(mix_hash(term.first, hash),
+                term.second * weight);
+    }
+}
+
+template<template<typename> class Hash, typename T>
+void cross_value(const T& value, const Terms& terms, Terms* output) {
+    cross(terms, Hash<T>()(value), 1, output);
+}
+
+template<template<typename> class Hash, typename T>
+void cross_value(const SparseVector<T>& value, const Terms& terms,
+        Terms* output) {
+    for (size_t i = 0; i < value.nnz(); i++) {
+        cross(terms, value.indices[i], value.values[i], output);
+    }
+}
+
+template<template<typename> class Hash, typename T>
+void cross_value(const std::vector<T>& value, const Terms& terms,
+        Terms* output) {
+    for (size_t i = 0; i < value.size(); i++) {
+        if (value[i] != 0) {
+            cross(terms, i, value[i], output);
+        }
+    }
+}
+
+template<template<typename> class Hash>
+void cross_value(const BitVector& value, const Terms& terms, Terms* output) {
+    for_each_nonzero(value, [&](size_t i, double weight) {
+        cross(terms, i, weight, output);
+    });
+}
+
+template<typename From, template<typename> class Hash>
+struct CrossInputs {
+    static void apply(const From& sample, Terms* terms, Terms* buffer) {
+        buffer->clear();
+        cross_value<Hash>(sample, *terms, buffer);
+        terms->swap(*buffer);
+    }
+};
+
+template<typename... Ts, template<typename> class Hash>
+struct CrossInputs<std::tuple<Ts...>, Hash> {
+    template<size_t Index = 0>
+    static typename std::enable_if<Index < sizeof...(Ts)>::type apply(
+            const std::tuple<Ts...>& sample, Terms* terms,
+            Terms* buffer) {
+        typedef typename std::tuple_element<Index, std::tuple<Ts...>>::type T;
+        CrossInputs<T, Hash>::apply(std::get<Index>(sample), terms, buffer);
+        apply<Index + 1>(sample, terms, buffer);
+    }
+
+    template<size_t Index>
+    static typename std::enable_if<Index == sizeof...(Ts)>::type apply(
+            const std::tuple<Ts...>&, Terms*, Terms*) {
+    }
+};
+} // namespace: cross_detail
+
+template<typename From, template<typename> class Hash = FastHash>
+class FeatureCross : public Transformer<From, SparseVector<double>> {
+public:
+    /**
+     * Output has num_buckets dimensions. Crosses with different seeds
+     * collide on different combinations. Hash is the hash policy of
+     * categorical values.
+     */
+    explicit FeatureCross(size_t num_buckets = 1 << 20, uint64_t seed = 0) :
+            _num_buckets(num_buckets), _seed(seed) {
+        if (num_buckets == 0 || num_buckets > UINT32_MAX) {
+            throw std::invalid_argument("FeatureCross: bad num_buckets");
+        }
+    }
+
+    virtual SparseVector<double> transform(const From& sample) const {
+        ArenaScope scope;
+        cross_detail::Terms terms = scope.vector<cross_detail::Term>();
+        cross_detail::Terms buffer = scope.vector<cross_detail::Term>();
+        terms.emplace_back(_seed, 1);
+        cross_detail::CrossInputs<From, Hash>::apply(sample, &terms, &buffer);
+        for (auto& term : terms) {
+            term.first %= _num_buckets;
+        }
+        std::sort(terms.begin(), terms.end());
+        SparseVector<double> output(_num_buckets);
+        output.indices.reserve(terms.size());
+        output.values.reserve(terms.size());
+        for (const auto& term : terms) {
+            uint32_t index = static_cast<uint32_t>(term.first);
+            if (output.nnz() > 0 && output.indices.back() == index) {
+                output.values.back() += term.second;
+            } else {
+                output.push_back(index, term.second);
+            }
+        }
+        return output;
+    }
+
+    virtual size_t output_dim() const {
+        return _num_buckets;
+    }
+
+    size_t num_buckets() const {
+        return _num_buckets;
+    }
+
+    virtual std::shared_ptr<Transformer<From, SparseVector<double>>>
+    clone() const {
+        return std::make_shared<FeatureCross>(*this);
+    }
+
+private:
+    size_t _num_buckets;
+    uint64_t _seed;
+};
+} // namespace: transformer
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * FitSession fits many independent transformers (roots) over the same data.
+ *
+ * Every root is usually a whole pipeline. Instead of each pipeline iterating
+ * the dataset on its own, the session reads every sample once and steps all
+ * the roots with it. Optionally the roots are stepped on a thread pool, one
+ * task per root and batch.
+ */
+#ifndef FASTFEA_FIT_SESSION_H
+#define FASTFEA_FIT_SESSION_H
+
+#include <memory>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+template<typename From>
+class FitSession {
+public:
+    /**
+     * With num_threads > 1, step_batch and finalize run the roots
+     * concurrently. Roots then must not share any transformer that is still
+     * learning, since a transformer's step isn't thread-safe. Sharing
+     * finalized ones (e.g. LazyTransformer) is fine.
+     */
+    explicit FitSession(size_t num_threads = 1) {
+        if (num_threads > 1) {
+            _pool.reset(new ThreadPool(num_threads));
+        }
+    }
+
+    template<typename To>
+    void add(std::shared_ptr<Transformer<From, To>> root) {
+        _roots.emplace_back(new RootImpl<To>(std::move(root)));
+    }
+
+    size_t size() const {
+        return _roots.size();
+    }
+
+    /**
+     * Step all roots with one sample. This is always sequential, one sample
+     * is too little work to hand over to other threads; use step_batch for
+     * that.
+     */
+    void step(const From& sample) {
+        for (auto& root : _roots) {
+            if (!root->is_finalized()) {
+                root->step(sample);
+            }
+        }
+    }
+
+    void step_batch(const std::vector<From>& samples) {
+        for_each_root([&samples](Root& root) {
+            if (!root.is_finalized()) {
+                root.step_batch(samples);
+            }
+        });
+    }
+
+    void finalize() {
+        for_each_root([](Root& root) {
+            if (!root.is_finalized()) {
+                root.finalize();
+            }
+        });
+    }
+
+private:
+    struct Root {
+        virtual ~Root() {}
+        virtual void step(const From& sample) = 0;
+        virtual void step_batch(const std::vector<From>& samples) = 0;
+        virtual void finalize() = 0;
+        virtual bool is_finalized() const = 0;
+    };
+
+    template<typename To>
+    struct RootImpl : public Root {
+        explicit RootImpl(std::shared_ptr<Transformer<From, To>> transformer) :
+                _transformer(std::move(transformer)) {}
+
+        virtual void step(const From& sample) {
+            _transformer->step(sample);
+        }
+        virtual void step_batch(const std::vector<From>& samples) {
+            _transformer->step_batch(samples);
+        }
+        virtual void finalize() {
+            _transformer->finalize();
+        }
+        virtual bool is_finalized() const {
+            return _transformer->is_finalized();
+        }
+
+        std::shared_ptr<Transformer<From, To>> _transformer;
+    };
+
+    template<typename Func>
+    void for_each_root(Func func) {
+        if (!_pool || _roots.size() < 2) {
+            for (auto& root : _roots) {
+                func(*root);
+            }
+            return;
+        }
+        std::vector<std::shared_ptr<Task>> tasks;
+        for (auto& root : _roots) {
+            Root* ptr = root.get();
+            tasks.push_back(_pool->submit([func, ptr]() { func(*ptr); }));
+        }
+        wait_all(tasks);
+    }
+
+    std::vector<std::unique_ptr<Root>> _roots;
+    std::unique_ptr<ThreadPool> _pool;
+};
+} // namespace: transformer
+
+#endif
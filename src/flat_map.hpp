@@ -0,0 +1,145 @@
+/**
+ * FlatHashMap: hash map with open addressing, for counting tables hit once
+ * per sample (document frequencies, category counts).
+ *
+ * Keys and values live in flat arrays and a collision probes the next
+ * slot (linear probing), so a lookup usually touches one or two cache lines
+ * instead of chasing std::unordered_map's per-node allocations. No erase:
+ * counting tables only grow.
+ */
+#ifndef FASTFEA_FLAT_MAP_H
+#define FASTFEA_FLAT_MAP_H
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "hasher.hpp"
+
+namespace transformer {
+
+template<typename K, typename V, typename Hash = std::hash<K>>
+class FlatHashMap {
+public:
+    FlatHashMap() {}
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    void clear() {
+        _keys.clear();
+        _values.clear();
+        _used.clear();
+        _size = 0;
+    }
+
+    /**
+     * Make room for n keys without rehashing.
+     */
+    void reserve(size_t n) {
+        size_t capacity = kMinCapacity;
+        while (capacity < 2 * n) {
+            capacity *= 2;
+        }
+        if (capacity > _used.size()) {
+            rehash(capacity);
+        }
+    }
+
+    const V* find(const K& key) const {
+        if (_size == 0) {
+            return nullptr;
+        }
+        size_t mask = _used.size() - 1;
+        for (size_t i = slot(key); _used[i]; i = (i + 1) & mask) {
+            if (_keys[i] == key) {
+                return &_values[i];
+            }
+        }
+        return nullptr;
+    }
+
+    V* find(const K& key) {
+        return const_cast<V*>(
+                static_cast<const FlatHashMap*>(this)->find(key));
+    }
+
+    /**
+     * Value of key, inserted value-initialized when missing.
+     */
+    V& operator[](const K& key) {
+        // Load factor stays at most 1/2, keeping probe sequences short.
+        if (2 * (_size + 1) > _used.size()) {
+            rehash(_used.empty() ? size_t(kMinCapacity) : 2 * _used.size());
+        }
+        size_t mask = _used.size() - 1;
+        size_t i = slot(key);
+        for (; _used[i]; i = (i + 1) & mask) {
+            if (_keys[i] == key) {
+                return _values[i];
+            }
+        }
+        _used[i] = 1;
+        _keys[i] = key;
+        _values[i] = V();
+        _size++;
+        return _values[i];
+    }
+
+    /**
+     * Call func(key, value) on every entry, in no particular order.
+     */
+    template<typename Func>
+    void for_each(Func func) const {
+        for (size_t i = 0; i < _used.size(); i++) {
+            if (_used[i]) {
+                func(_keys[i], _values[i]);
+            }
+        }
+    }
+
+private:
+    static const size_t kMinCapacity = 16;
+
+    size_t slot(const K& key) const {
+        // std::hash of an integer is the integer, spread it over the bits
+        // the mask keeps.
+        return mix_hash(0, Hash()(key)) & (_used.size() - 1);
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<K> keys(capacity);
+        std::vector<V> values(capacity);
+        std::vector<uint8_t> used(capacity);
+        keys.swap(_keys);
+        values.swap(_values);
+        used.swap(_used);
+        size_t mask = capacity - 1;
+        for (size_t j = 0; j < used.size(); j++) {
+            if (!used[j]) {
+                continue;
+            }
+            size_t i = slot(keys[j]);
+            while (_used[i]) {
+                i = (i + 1) & mask;
+            }
+            _used[i] = 1;
+            _keys[i] = std::move(keys[j]);
+            _values[i] = std::move(values[j]);
+        }
+    }
+
+    std::vector<K> _keys;
+    std::vector<V> _values;
+    std::vector<uint8_t> _used;
+    size_t _size = 0;
+};
+} // namespace: transformer
+
+#endif
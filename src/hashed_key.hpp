@@ -0,0 +1,157 @@
+/**
+ * HashedKey: a value with its hash, computed once.
+ *
+ * A feature feeding several hashed consumers, e.g.
+ *
+ *   extract + make_transformer<HashKey<std::string>>() + (
+ *       make_transformer<Binarizer<HashedKey<std::string>>>() |
+ *       make_transformer<CountEncoder<HashedKey<std::string>>>())
+ *
+ * is otherwise hashed again by each of them, and on every lookup. Hash
+ * tables and encoders hash a HashedKey by returning the hash it carries,
+ * whether their policy is FastHash or std::hash, and compare keys by hash
+ * before comparing the values.
+ *
+ * The hash is FastHash<T> of the value, so a HashedKey<T> lands where T
+ * would with FastHash (same buckets, same sketch counters).
+ */
+#ifndef FASTFEA_HASHED_KEY_H
+#define FASTFEA_HASHED_KEY_H
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "hasher.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+template<typename T>
+class HashedKey {
+public:
+    /**
+     * T(), whose hash is computed once: tables default construct keys for
+     * their empty slots.
+     */
+    HashedKey() : _hash(default_hash()) {}
+    explicit HashedKey(const T& value) :
+            _value(value), _hash(FastHash<T>()(_value)) {}
+    explicit HashedKey(T&& value) :
+            _value(std::move(value)), _hash(FastHash<T>()(_value)) {}
+
+    const T& value() const {
+        return _value;
+    }
+
+    size_t hash() const {
+        return _hash;
+    }
+
+    bool operator==(const HashedKey& other) const {
+        return _hash == other._hash && _value == other._value;
+    }
+
+    bool operator!=(const HashedKey& other) const {
+        return !(*this == other);
+    }
+
+private:
+    static size_t default_hash() {
+        static const size_t hash = FastHash<T>()(T());
+        return hash;
+    }
+
+    T _value;
+    size_t _hash;
+};
+
+template<typename T>
+struct FastHash<HashedKey<T>> {
+    size_t operator()(const HashedKey<T>& key) const {
+        return key.hash();
+    }
+};
+
+/**
+ * Within a composite key (a tuple, a pair...), the hash stands for the
+ * value.
+ */
+template<typename T>
+struct HashAppend<HashedKey<T>> {
+    static void apply(HashState* state, const HashedKey<T>& key) {
+        state->update(key.hash());
+    }
+};
+
+/**
+ * Wrap values into HashedKeys, e.g. after the lazy transformer extracting
+ * them. A value the caller is done with is moved in.
+ */
+template<typename T>
+class HashKey : public Transformer<T, HashedKey<T>> {
+public:
+    HashKey() { this->_is_finalized = true; }
+
+    virtual HashedKey<T> transform(const T& sample) const {
+        return HashedKey<T>(sample);
+    }
+
+    virtual HashedKey<T> transform(T&& sample) {
+        return HashedKey<T>(std::move(sample));
+    }
+
+    virtual size_t output_dim() const {
+        return 1;
+    }
+
+    virtual std::shared_ptr<Transformer<T, HashedKey<T>>> clone() const {
+        return std::make_shared<HashKey>(*this);
+    }
+};
+
+/**
+ * HashKey for bags of values, e.g. tokens, for MultiHotBinarizer.
+ */
+template<typename T>
+class HashKeys :
+        public Transformer<std::vector<T>, std::vector<HashedKey<T>>> {
+public:
+    HashKeys() { this->_is_finalized = true; }
+
+    virtual std::vector<HashedKey<T>> transform(
+            const std::vector<T>& sample) const {
+        std::vector<HashedKey<T>> keys;
+        keys.reserve(sample.size());
+        for (const T& value : sample) {
+            keys.emplace_back(value);
+        }
+        return keys;
+    }
+
+    virtual std::vector<HashedKey<T>> transform(std::vector<T>&& sample) {
+        std::vector<HashedKey<T>> keys;
+        keys.reserve(sample.size());
+        for (T& value : sample) {
+            keys.emplace_back(std::move(value));
+        }
+        return keys;
+    }
+
+    virtual std::shared_ptr<typename HashKeys::BaseType> clone() const {
+        return std::make_shared<HashKeys>(*this);
+    }
+};
+} // namespace: transformer
+
+namespace std {
+    template<typename T>
+    struct hash<transformer::HashedKey<T>> {
+        size_t operator()(const transformer::HashedKey<T>& key) const {
+            return key.hash();
+        }
+    };
+}
+
+#endif
@@ -4,7 +4,243 @@
  */
 #ifndef FASTFEA_HASHER_H
 #define FASTFEA_HASHER_H value
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace transformer {
+
+/**
+ * Hash of value, chained after seed. Unlike hash_combine below, every bit
+ * of the result depends on every input bit (murmur3's finalizer), which
+ * matters when the hash is reduced to a few buckets: std::hash of an
+ * integer is the integer itself.
+ */
+inline uint64_t mix_hash(uint64_t seed, uint64_t value) {
+    uint64_t h = seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) +
+            (seed >> 2));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Hash of the bytes data[0, n), eight at a time.
+ */
+inline uint64_t hash_bytes(const char* data, size_t n, uint64_t seed = 0) {
+    uint64_t h = seed;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = mix_hash(h, word);
+    }
+    uint64_t word = 0;
+    if (i < n) {
+        std::memcpy(&word, data + i, n - i);
+    }
+    return mix_hash(h, word ^ (static_cast<uint64_t>(n) << 56));
+}
+
+/**
+ * multiply_fold from four 32x32 -> 64 bit multiplies, for targets without
+ * a 128-bit product (32-bit ones).
+ */
+inline uint64_t multiply_fold_portable(uint64_t a, uint64_t b) {
+    uint64_t a_lo = a & 0xffffffffULL, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xffffffffULL, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    uint64_t hi_hi = a_hi * b_hi;
+    // The middle column, with the carry out of the low 64 bits.
+    uint64_t middle = (lo_lo >> 32) + (hi_lo & 0xffffffffULL) +
+        (lo_hi & 0xffffffffULL);
+    uint64_t low = (middle << 32) | (lo_lo & 0xffffffffULL);
+    uint64_t high = hi_hi + (hi_lo >> 32) + (lo_hi >> 32) + (middle >> 32);
+    return low ^ high;
+}
+
+/**
+ * 64x64 -> 128 bit multiply, folded back to 64 bits (wyhash's mixer): one
+ * multiplication spreads every input bit over the result.
+ */
+inline uint64_t multiply_fold(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(product) ^
+        static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t high;
+    uint64_t low = _umul128(a, b, &high);
+    return low ^ high;
+#else
+    return multiply_fold_portable(a, b);
+#endif
+}
+
+/**
+ * Streaming hash, in the style of wyhash: the parts of a key (fields of a
+ * tuple, bytes of a string) are folded into one state as they come, rather
+ * than hashed on their own and then combined.
+ */
+class HashState {
+public:
+    explicit HashState(uint64_t seed = 0) : _h(seed ^ kSecret0) {}
+
+    void update(uint64_t value) {
+        _h = multiply_fold(value ^ kSecret1, _h ^ kSecret2);
+    }
+
+    /**
+     * The bytes data[0, n), 16 at a time, then their length: "ab", "c" and
+     * "a", "bc" differ.
+     */
+    void update_bytes(const char* data, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            uint64_t a, b;
+            std::memcpy(&a, data + i, 8);
+            std::memcpy(&b, data + i + 8, 8);
+            _h = multiply_fold(a ^ kSecret1, b ^ _h);
+        }
+        if (i < n) {
+            uint64_t tail[2] = {0, 0};
+            std::memcpy(tail, data + i, n - i);
+            _h = multiply_fold(tail[0] ^ kSecret1, tail[1] ^ _h);
+        }
+        update(n);
+    }
+
+    uint64_t finish() const {
+        return multiply_fold(_h ^ kSecret3, kSecret0);
+    }
+
+private:
+    static const uint64_t kSecret0 = 0xa0761d6478bd642fULL;
+    static const uint64_t kSecret1 = 0xe7037ed1a0b428dbULL;
+    static const uint64_t kSecret2 = 0x8ebc6af09c88c6e3ULL;
+    static const uint64_t kSecret3 = 0x589965cc75374cc3ULL;
+
+    uint64_t _h;
+};
+
+/**
+ * How a value goes into a HashState. Integers, floating point numbers,
+ * strings, and pairs, tuples, arrays and vectors of them are built in;
+ * anything else goes in through its std::hash.
+ */
+template<typename T, typename Enable = void>
+struct HashAppend {
+    static void apply(HashState* state, const T& value) {
+        state->update(std::hash<T>()(value));
+    }
+};
+
+template<typename T>
+struct HashAppend<T, typename std::enable_if<
+        std::is_integral<T>::value || std::is_enum<T>::value>::type> {
+    static void apply(HashState* state, T value) {
+        state->update(static_cast<uint64_t>(value));
+    }
+};
+
+template<typename T>
+struct HashAppend<T, typename std::enable_if<
+        std::is_floating_point<T>::value>::type> {
+    static void apply(HashState* state, T value) {
+        // -0.0 == 0.0, they must hash the same.
+        double x = value == 0 ? 0.0 : static_cast<double>(value);
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        state->update(bits);
+    }
+};
+
+template<>
+struct HashAppend<std::string> {
+    static void apply(HashState* state, const std::string& value) {
+        state->update_bytes(value.data(), value.size());
+    }
+};
+
+template<typename T, typename U>
+struct HashAppend<std::pair<T, U>> {
+    static void apply(HashState* state, const std::pair<T, U>& value) {
+        HashAppend<T>::apply(state, value.first);
+        HashAppend<U>::apply(state, value.second);
+    }
+};
+
+template<typename... Ts>
+struct HashAppend<std::tuple<Ts...>> {
+    static void apply(HashState* state, const std::tuple<Ts...>& value) {
+        apply_from<0>(state, value);
+    }
+
+private:
+    template<size_t Index>
+    static typename std::enable_if<Index < sizeof...(Ts)>::type apply_from(
+            HashState* state, const std::tuple<Ts...>& value) {
+        typedef typename std::tuple_element<Index,
+                std::tuple<Ts...>>::type T;
+        HashAppend<T>::apply(state, std::get<Index>(value));
+        apply_from<Index + 1>(state, value);
+    }
+
+    template<size_t Index>
+    static typename std::enable_if<Index == sizeof...(Ts)>::type apply_from(
+            HashState*, const std::tuple<Ts...>&) {
+    }
+};
+
+template<typename T, size_t N>
+struct HashAppend<std::array<T, N>> {
+    static void apply(HashState* state, const std::array<T, N>& value) {
+        for (const T& item : value) {
+            HashAppend<T>::apply(state, item);
+        }
+    }
+};
+
+template<typename T>
+struct HashAppend<std::vector<T>> {
+    static void apply(HashState* state, const std::vector<T>& value) {
+        for (const T& item : value) {
+            HashAppend<T>::apply(state, item);
+        }
+        state->update(value.size());
+    }
+};
+
+/**
+ * Hash policy of the hashed transformers (Binarizer, CountEncoder,
+ * FeatureCross...): a drop-in for std::hash<T>, well mixed in every bit,
+ * and hashing composite keys in one pass. std::hash is a valid policy
+ * too.
+ */
+template<typename T>
+struct FastHash {
+    size_t operator()(const T& value) const {
+        HashState state;
+        HashAppend<T>::apply(&state, value);
+        return state.finish();
+    }
+};
+} // namespace: transformer
 ///////////////////  TUPLE
 // from http://stackoverflow.com/questions/7110301/generic-hash-for-tuples-in-unordered-map-unordered-set
 namespace std {
@@ -52,19 +288,22 @@ namespace std {
 
 ///////////////////  PAIR
 
+// Ordered like tuples: a plain xor of the two hashes would make (a, b)
+// collide with (b, a), and (x, x) hash to 0.
 namespace std {
     template <class T, class U>
         struct hash<pair<T,U>> {
             size_t operator()(const pair<T,U>& val ) const {
-                return hash<T>()(val.first) ^ hash<U>()(val.second);
+                size_t seed = 0;
+                hash_combine(seed, val.first);
+                hash_combine(seed, val.second);
+                return seed;
             }
     };
 };
 
 ///////////////////  ARRAY
 
-#include <array>
-
 namespace std {
         template<typename T, size_t N>
     struct hash<array<T, N> > {
@@ -72,12 +311,11 @@ namespace std {
         typedef size_t result_type;
 
         result_type operator()(const argument_type& a) const {
-            hash<T> hasher;
-            result_type h = 0;
+            result_type seed = 0;
             for (result_type i = 0; i < N; ++i) {
-                h = h * 31 + hasher(a[i]);
+                hash_combine(seed, a[i]);
             }
-            return h;
+            return seed;
         }
     };
 }
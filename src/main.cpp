@@ -38,7 +38,7 @@ int main(int argc, char *argv[])
     }
     pipe->finalize();
     for (const auto& data: dataset) {
-        std::vector<double> out = pipe->transform(data);
+        std::vector<transformer::FeatureValue> out = pipe->transform(data);
         for (const auto& item: out) {
             std::cout<<item<<" ";
         }
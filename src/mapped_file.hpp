@@ -0,0 +1,156 @@
+/**
+ * MappedFile: a whole file mapped in memory (POSIX mmap), read-only.
+ *
+ * Readers hand out views into the mapping instead of copying the data, the
+ * kernel pages the file in as it's read.
+ *
+ * MappedOutputFile: a new file of a given size mapped for writing, filled in
+ * place (by several threads, in disjoint parts) and written back by the
+ * kernel.
+ */
+#ifndef FASTFEA_MAPPED_FILE_H
+#define FASTFEA_MAPPED_FILE_H
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace transformer {
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("MappedFile: can't open " + path + ": " +
+                    std::strerror(errno));
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("MappedFile: can't stat " + path + ": " +
+                    std::strerror(error));
+        }
+        _size = static_cast<size_t>(info.st_size);
+        // Mapping 0 bytes fails, an empty file is simply no data.
+        if (_size > 0) {
+            void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                int error = errno;
+                ::close(fd);
+                throw std::runtime_error("MappedFile: can't map " + path +
+                        ": " + std::strerror(error));
+            }
+            _data = static_cast<const char*>(data);
+            ::madvise(data, _size, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (_data) {
+            ::munmap(const_cast<char*>(_data), _size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+};
+
+class MappedOutputFile {
+public:
+    /**
+     * Create (or truncate) path, size bytes of zeros.
+     */
+    MappedOutputFile(const std::string& path, size_t size) :
+            _path(path), _size(size) {
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("MappedOutputFile: can't open " + path +
+                    ": " + std::strerror(errno));
+        }
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("MappedOutputFile: can't resize " +
+                    path + ": " + std::strerror(error));
+        }
+        if (_size > 0) {
+            void* data = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+            if (data == MAP_FAILED) {
+                int error = errno;
+                ::close(fd);
+                throw std::runtime_error("MappedOutputFile: can't map " +
+                        path + ": " + std::strerror(error));
+            }
+            _data = static_cast<char*>(data);
+        }
+        ::close(fd);
+    }
+
+    /**
+     * Unmaps, ignoring errors: call close() to see them.
+     */
+    ~MappedOutputFile() {
+        if (_data) {
+            ::munmap(_data, _size);
+        }
+    }
+
+    MappedOutputFile(const MappedOutputFile&) = delete;
+    MappedOutputFile& operator=(const MappedOutputFile&) = delete;
+
+    char* data() {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * Write the data back to the file and unmap it.
+     */
+    void close() {
+        if (!_data) {
+            return;
+        }
+        char* data = _data;
+        _data = nullptr;
+        bool synced = ::msync(data, _size, MS_SYNC) == 0;
+        int error = errno;
+        ::munmap(data, _size);
+        if (!synced) {
+            throw std::runtime_error("MappedOutputFile: can't write " +
+                    _path + ": " + std::strerror(error));
+        }
+    }
+
+private:
+    std::string _path;
+    char* _data = nullptr;
+    size_t _size = 0;
+};
+} // namespace: transformer
+
+#endif
@@ -0,0 +1,299 @@
+/**
+ * Built-in transformers for scalar numeric features.
+ *
+ * Unlike a LazyTransformer wrapping a lambda, they transform a whole batch
+ * with the vectorized kernels of simd.hpp, over one contiguous column. They
+ * are element-wise, so a pipeline of them runs as one loop once fitted (see
+ * elementwise.hpp).
+ *
+ * T, the type of the values, is FeatureValue unless given (double or
+ * float). Fitted statistics are accumulated in double either way.
+ */
+#ifndef FASTFEA_NUMERIC_H
+#define FASTFEA_NUMERIC_H
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "elementwise.hpp"
+#include "simd.hpp"
+#include "standardizer.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+/**
+ * log(1 + x), for skewed non-negative features such as counts.
+ */
+template<typename T = FeatureValue>
+class Log1p : public ElementwiseTransformer<T> {
+public:
+    virtual T transform(const T& sample) const {
+        return simd::log1p(sample);
+    }
+
+    virtual void apply(T* data, size_t n) const {
+        simd::log1p(data, data, n);
+    }
+
+    virtual std::shared_ptr<Transformer<T, T>> clone() const {
+        return std::make_shared<Log1p>(*this);
+    }
+};
+
+/**
+ * Clamp to [lower, upper], e.g. to cap outliers.
+ */
+template<typename T = FeatureValue>
+class Clip : public ElementwiseTransformer<T> {
+public:
+    Clip(T lower, T upper) : _lower(lower), _upper(upper) {
+        if (lower > upper) {
+            throw std::invalid_argument("Clip: lower above upper");
+        }
+    }
+
+    virtual T transform(const T& sample) const {
+        T output;
+        simd::clip(&sample, &output, 1, _lower, _upper);
+        return output;
+    }
+
+    virtual void apply(T* data, size_t n) const {
+        simd::clip(data, data, n, _lower, _upper);
+    }
+
+    virtual std::shared_ptr<Transformer<T, T>> clone() const {
+        return std::make_shared<Clip>(*this);
+    }
+
+private:
+    T _lower;
+    T _upper;
+};
+
+/**
+ * Scale linearly so that the smallest value seen maps to 0 and the largest
+ * to 1. Values outside of what was seen map outside of [0, 1]. A constant
+ * feature maps to 0.
+ */
+template<typename T = FeatureValue>
+class MinMaxScaler : public ElementwiseTransformer<T> {
+public:
+    MinMaxScaler() { this->_is_finalized = false; }
+
+    virtual void step(const T& sample) {
+        if (std::isnan(sample)) {
+            return;
+        }
+        if (_count == 0 || sample < _min) {
+            _min = sample;
+        }
+        if (_count == 0 || sample > _max) {
+            _max = sample;
+        }
+        _count++;
+    }
+
+    void merge(const MinMaxScaler& other) {
+        if (other._count == 0) {
+            return;
+        }
+        if (_count == 0 || other._min < _min) {
+            _min = other._min;
+        }
+        if (_count == 0 || other._max > _max) {
+            _max = other._max;
+        }
+        _count += other._count;
+    }
+
+    virtual void finalize() {
+        double scale = _max > _min ?
+            1 / (static_cast<double>(_max) - _min) : 1;
+        _scale = static_cast<T>(scale);
+        _shift = static_cast<T>(-_min * scale);
+        this->_is_finalized = true;
+    }
+
+    virtual void extend() {
+        this->_is_finalized = false;
+    }
+
+    virtual T transform(const T& sample) const {
+        return sample * _scale + _shift;
+    }
+
+    virtual void apply(T* data, size_t n) const {
+        simd::affine(data, data, n, _scale, _shift);
+    }
+
+    virtual bool affine(T* scale, T* shift) const {
+        *scale = _scale;
+        *shift = _shift;
+        return true;
+    }
+
+    T min() const {
+        return _min;
+    }
+
+    T max() const {
+        return _max;
+    }
+
+    virtual std::shared_ptr<Transformer<T, T>> clone() const {
+        return std::make_shared<MinMaxScaler>(*this);
+    }
+
+private:
+    uint64_t _count = 0;
+    T _min = 0;
+    T _max = 0;
+    T _scale = 1;
+    T _shift = 0;
+};
+
+/**
+ * Power transform making a feature more Gaussian-like: Box-Cox (positive
+ * values only) or Yeo-Johnson (any value). The output is standardized.
+ *
+ * The exponent lambda is the maximum likelihood one, picked among a grid of
+ * candidates in [-2, 2] by steps of 0.1. The likelihood of each candidate
+ * only needs the moments of the transformed values plus a sum over the
+ * samples, so step keeps those for every candidate, and fitting stays a
+ * single streaming pass (and mergeable, and extendable).
+ *
+ * No SIMD for the power itself, libm's pow/expm1 are called per element;
+ * the standardization that follows is vectorized.
+ */
+template<typename T = FeatureValue>
+class PowerTransformer : public ElementwiseTransformer<T> {
+public:
+    enum Method {
+        BoxCox,
+        YeoJohnson,
+    };
+
+    explicit PowerTransformer(Method method = YeoJohnson) :
+            _method(method), _moments(kNumLambdas) {
+        this->_is_finalized = false;
+    }
+
+    virtual void step(const T& sample) {
+        double x = sample;
+        if (std::isnan(x)) {
+            return;
+        }
+        if (_method == BoxCox && !(x > 0)) {
+            throw std::domain_error("PowerTransformer: Box-Cox needs x > 0");
+        }
+        for (size_t i = 0; i < kNumLambdas; i++) {
+            _moments[i].push(power(x, lambda_at(i)));
+        }
+        _log_jacobian += _method == BoxCox ? std::log(x) :
+            std::copysign(std::log1p(std::fabs(x)), x);
+    }
+
+    void merge(const PowerTransformer& other) {
+        for (size_t i = 0; i < kNumLambdas; i++) {
+            _moments[i].merge(other._moments[i]);
+        }
+        _log_jacobian += other._log_jacobian;
+    }
+
+    virtual void finalize() {
+        double best = -HUGE_VAL;
+        size_t best_index = lambda_index(1);
+        for (size_t i = 0; i < kNumLambdas; i++) {
+            double variance = _moments[i].variance();
+            if (!(variance > 0)) {
+                continue;
+            }
+            double likelihood = -0.5 * _moments[i].count * std::log(variance) +
+                (lambda_at(i) - 1) * _log_jacobian;
+            if (likelihood > best) {
+                best = likelihood;
+                best_index = i;
+            }
+        }
+        _lambda = lambda_at(best_index);
+        const Moments& moments = _moments[best_index];
+        double stddev = std::sqrt(moments.variance());
+        double scale = stddev > 0 ? 1 / stddev : 1;
+        _scale = static_cast<T>(scale);
+        _shift = static_cast<T>(-moments.mean * scale);
+        this->_is_finalized = true;
+    }
+
+    virtual void extend() {
+        this->_is_finalized = false;
+    }
+
+    double lambda() const {
+        return _lambda;
+    }
+
+    virtual T transform(const T& sample) const {
+        return static_cast<T>(power(sample, _lambda)) * _scale + _shift;
+    }
+
+    virtual void apply(T* data, size_t n) const {
+        for (size_t i = 0; i < n; i++) {
+            data[i] = static_cast<T>(power(data[i], _lambda));
+        }
+        simd::affine(data, data, n, _scale, _shift);
+    }
+
+    virtual std::shared_ptr<Transformer<T, T>> clone() const {
+        return std::make_shared<PowerTransformer>(*this);
+    }
+
+private:
+    static const size_t kNumLambdas = 41;
+
+    static double lambda_at(size_t i) {
+        return -2 + 0.1 * i;
+    }
+
+    static size_t lambda_index(double lambda) {
+        return static_cast<size_t>(std::lround((lambda + 2) * 10));
+    }
+
+    // (x^lambda - 1) / lambda, written as expm1 to stay accurate near 0.
+    static double box_cox(double x, double lambda) {
+        double log_x = std::log(x);
+        if (std::fabs(lambda) < 1e-8) {
+            return log_x;
+        }
+        return std::expm1(lambda * log_x) / lambda;
+    }
+
+    double power(double x, double lambda) const {
+        if (_method == BoxCox) {
+            return box_cox(x, lambda);
+        }
+        if (x >= 0) {
+            if (std::fabs(lambda) < 1e-8) {
+                return std::log1p(x);
+            }
+            return std::expm1(lambda * std::log1p(x)) / lambda;
+        }
+        if (std::fabs(lambda - 2) < 1e-8) {
+            return -std::log1p(-x);
+        }
+        return -std::expm1((2 - lambda) * std::log1p(-x)) / (2 - lambda);
+    }
+
+    Method _method;
+    std::vector<Moments> _moments;
+    double _log_jacobian = 0;
+    double _lambda = 1;
+    T _scale = 1;
+    T _shift = 0;
+};
+} // namespace: transformer
+
+#endif
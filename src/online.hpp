@@ -0,0 +1,205 @@
+/**
+ * Keep transforming with a fitted transformer while it keeps learning.
+ *
+ * OnlineTransformer owns a private working copy of a transformer, which step
+ * keeps updating, and an immutable published snapshot, which transform reads.
+ * publish() copies the working state into a new snapshot and swaps it in, so
+ * readers never see a half-updated vocabulary, and never wait for writers.
+ */
+#ifndef FASTFEA_ONLINE_H
+#define FASTFEA_ONLINE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "transformer.hpp"
+
+namespace transformer {
+
+/**
+ * A pointer readers can follow without locking, while a writer replaces it
+ * (read-copy-update).
+ *
+ * Readers register in one of two counters, picked by the current epoch.
+ * After swapping the pointer, publish moves to the next epoch and waits for
+ * the readers registered in the previous one, the only ones that might
+ * still hold the old value, before deleting it. So readers only pay two
+ * atomic increments, and the cost of reclaiming falls on the writer.
+ */
+template<typename T>
+class RcuCell {
+public:
+    class ReadGuard {
+    public:
+        ReadGuard(const RcuCell& cell) : _cell(&cell) {
+            while (true) {
+                size_t epoch = cell._epoch.load();
+                _slot = epoch & 1;
+                cell._readers[_slot].fetch_add(1);
+                // Registered too late for the epoch we read, a writer may
+                // have stopped waiting on this counter already.
+                if (cell._epoch.load() == epoch) {
+                    break;
+                }
+                cell._readers[_slot].fetch_sub(1);
+            }
+            _value = cell._current.load();
+        }
+        ReadGuard(ReadGuard&& other) : _cell(other._cell), _slot(other._slot),
+                _value(other._value) {
+            other._cell = nullptr;
+        }
+        ~ReadGuard() {
+            if (_cell) {
+                _cell->_readers[_slot].fetch_sub(1);
+            }
+        }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        /**
+         * Valid as long as the guard is alive, null when nothing was
+         * published yet.
+         */
+        const T* get() const {
+            return _value;
+        }
+
+    private:
+        const RcuCell* _cell;
+        size_t _slot;
+        const T* _value;
+    };
+
+    RcuCell() {
+        _readers[0].store(0);
+        _readers[1].store(0);
+    }
+    ~RcuCell() {
+        delete _current.load();
+    }
+    RcuCell(const RcuCell&) = delete;
+    RcuCell& operator=(const RcuCell&) = delete;
+
+    ReadGuard read() const {
+        return ReadGuard(*this);
+    }
+
+    /**
+     * Replace the value. Returns once no reader can see the previous one.
+     */
+    void publish(std::unique_ptr<const T> value) {
+        std::lock_guard<std::mutex> lock(_writer_mutex);
+        const T* old = _current.exchange(value.release());
+        size_t old_slot = _epoch.fetch_add(1) & 1;
+        while (_readers[old_slot].load() != 0) {
+            std::this_thread::yield();
+        }
+        delete old;
+    }
+
+private:
+    std::atomic<const T*> _current{nullptr};
+    std::atomic<size_t> _epoch{0};
+    mutable std::atomic<size_t> _readers[2];
+    std::mutex _writer_mutex;
+};
+
+/**
+ * T is a concrete, copyable transformer, e.g. Binarizer<std::string>, or a
+ * composite such as a Pipeline: copying one clones its stages (see
+ * Transformer::clone), so the snapshot doesn't share them with the working
+ * copy. Stages that can't be cloned throw logic_error on publish.
+ *
+ * Call publish() rather than finalize() to make what was learned so far
+ * visible; finalize() does the same. The snapshot is a copy of the working
+ * state finalized on its own, the working copy itself is never finalized
+ * and keeps accepting step.
+ *
+ * step and publish may be called from any number of writer threads (they are
+ * serialized), transform from any number of reader threads.
+ */
+template<typename T>
+class OnlineTransformer : public Transformer<typename T::FromType,
+        typename T::ToType> {
+    using From = typename T::FromType;
+    using To = typename T::ToType;
+public:
+    explicit OnlineTransformer(T working = T()) : _working(std::move(working)) {
+        this->_is_finalized = false;
+    }
+
+    virtual void step(const From& sample) {
+        std::lock_guard<std::mutex> lock(_working_mutex);
+        _working.step(sample);
+    }
+
+    virtual void step_batch(const std::vector<From>& samples) {
+        std::lock_guard<std::mutex> lock(_working_mutex);
+        _working.step_batch(samples);
+    }
+
+    /**
+     * Copying holds back step for a moment, finalizing the copy doesn't.
+     */
+    void publish() {
+        std::unique_ptr<T> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(_working_mutex);
+            snapshot.reset(new T(_working));
+        }
+        snapshot->finalize();
+        _snapshot.publish(std::unique_ptr<const T>(std::move(snapshot)));
+        _version.fetch_add(1);
+    }
+
+    virtual void finalize() {
+        publish();
+    }
+
+    /**
+     * Number of snapshots published so far.
+     */
+    size_t version() const {
+        return _version.load();
+    }
+
+    virtual To transform(const From& sample) const {
+        auto guard = _snapshot.read();
+        return published(guard)->transform(sample);
+    }
+
+    using Transformer<From, To>::transform_batch;
+
+    virtual std::vector<To> transform_batch(const From* first,
+            size_t n) const {
+        // The whole batch sees the same snapshot.
+        auto guard = _snapshot.read();
+        return published(guard)->transform_batch(first, n);
+    }
+
+    virtual size_t output_dim() const {
+        auto guard = _snapshot.read();
+        return guard.get() ? guard.get()->output_dim() : 0;
+    }
+
+private:
+    static const T* published(
+            const typename RcuCell<T>::ReadGuard& guard) {
+        if (!guard.get()) {
+            throw std::logic_error("OnlineTransformer: nothing published yet");
+        }
+        return guard.get();
+    }
+
+    T _working;
+    std::mutex _working_mutex;
+    RcuCell<T> _snapshot;
+    std::atomic<size_t> _version{0};
+};
+} // namespace: transformer
+
+#endif
@@ -0,0 +1,270 @@
+/**
+ * Combiner that may evaluate its two branches concurrently.
+ *
+ * Combiner runs _first and then _second, so its latency is the sum of the two.
+ * ParallelCombiner hands _first to a thread pool and runs _second on the
+ * calling thread, so the latency becomes (roughly) the max of the two. Handing
+ * work over to another thread costs a few microseconds, which is more than
+ * most transformers take for a row, so it only does so when both branches are
+ * expensive enough.
+ *
+ * The cost of each branch is measured on every call (exponential moving
+ * average), and can be seeded with an estimate beforehand. step and transform
+ * are measured separately.
+ */
+#ifndef FASTFEA_PARALLEL_COMBINER_H
+#define FASTFEA_PARALLEL_COMBINER_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "thread_pool.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+/**
+ * Moving average of how long something takes, in nanoseconds. Updates from
+ * concurrent callers may overwrite each other, which is fine for a heuristic.
+ */
+class CostEstimate {
+public:
+    CostEstimate() {}
+    CostEstimate(const CostEstimate& other) : _nanos(other.get()) {}
+
+    double get() const {
+        return _nanos.load(std::memory_order_relaxed);
+    }
+
+    void set(double nanos) {
+        _nanos.store(nanos, std::memory_order_relaxed);
+    }
+
+    void update(double nanos) {
+        double old = get();
+        set(old == 0 ? nanos : old + (nanos - old) / 8);
+    }
+
+    /**
+     * Run func and account its duration, spread over count calls (e.g. the
+     * rows of a batch).
+     */
+    template<typename Func>
+    void measure(Func func, size_t count = 1) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        update(std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - start).count() / count);
+    }
+
+private:
+    std::atomic<double> _nanos{0};
+};
+
+template<typename From, typename To1, typename To2>
+class ParallelCombiner : public Combiner<From, To1, To2> {
+    using Transformer1T = Transformer<From, To1>;
+    using Transformer2T = Transformer<From, To2>;
+    using CombineT = decltype(combine(To1(), To2()));
+public:
+    /**
+     * Branches are only run concurrently when both are expected to take at
+     * least min_parallel_nanos.
+     *
+     * Concurrent step requires the two branches not to share a transformer
+     * that is still learning.
+     */
+    ParallelCombiner(const std::shared_ptr<Transformer1T> first,
+            const std::shared_ptr<Transformer2T> second,
+            std::shared_ptr<ThreadPool> pool,
+            double min_parallel_nanos = 20000) :
+            Combiner<From, To1, To2>(std::move(first), std::move(second)),
+            _pool(std::move(pool)), _min_parallel_nanos(min_parallel_nanos) {}
+
+    /**
+     * Seed the cost of each branch's transform, e.g. from offline profiling,
+     * rather than learn it from the first calls.
+     */
+    void set_cost_estimate(double first_nanos, double second_nanos) {
+        _transform_cost[0].set(first_nanos);
+        _transform_cost[1].set(second_nanos);
+    }
+
+    virtual void step(const From& sample) {
+        step_branches(sample, nullptr);
+    }
+
+    virtual void step(From&& sample) {
+        step_branches(sample, &sample);
+    }
+
+    virtual CombineT transform(const From& sample) const {
+        return transform_branches(sample, nullptr);
+    }
+
+    virtual CombineT transform(From&& sample) {
+        return transform_branches(sample, &sample);
+    }
+
+    /**
+     * A batch costs the cost of a row times its size, so batches go
+     * parallel sooner than single rows.
+     */
+    using Combiner<From, To1, To2>::transform_batch;
+
+    virtual std::vector<CombineT> transform_batch(const From* first,
+            size_t n) const {
+        return transform_batch_branches(first, n, nullptr);
+    }
+
+    virtual std::vector<CombineT> transform_batch(
+            std::vector<From>&& samples) {
+        return transform_batch_branches(samples.data(), samples.size(),
+                &samples);
+    }
+
+    /**
+     * The clone shares the pool, and starts from the cost estimates learned
+     * so far.
+     */
+    virtual std::shared_ptr<Transformer<From, CombineT>> clone() const {
+        return std::make_shared<ParallelCombiner>(*this);
+    }
+
+private:
+    // The helpers below take the sample, and a pointer to it when the caller
+    // is done with it. The second branch is then handed it as an rvalue,
+    // once the first is done reading it: not when run concurrently.
+
+    void step_branches(const From& sample, From* owned) {
+        bool step_first = !this->_first->is_finalized();
+        bool step_second = !this->_second->is_finalized();
+        auto run_first = [&]() {
+            _step_cost[0].measure([&]() { this->_first->step(sample); });
+        };
+        if (step_first && step_second && worth_parallel(_step_cost)) {
+            run_concurrently(run_first, [&]() {
+                _step_cost[1].measure([&]() { this->_second->step(sample); });
+            });
+            return;
+        }
+        if (step_first) {
+            run_first();
+        }
+        if (step_second) {
+            _step_cost[1].measure([&]() {
+                if (owned) {
+                    this->_second->step(std::move(*owned));
+                } else {
+                    this->_second->step(sample);
+                }
+            });
+        }
+    }
+
+    CombineT transform_branches(const From& sample, From* owned) const {
+        if (!worth_parallel(_transform_cost)) {
+            To1 first_out;
+            To2 second_out;
+            _transform_cost[0].measure([&]() {
+                first_out = this->_first->transform(sample);
+            });
+            _transform_cost[1].measure([&]() {
+                second_out = owned ?
+                    this->_second->transform(std::move(*owned)) :
+                    this->_second->transform(sample);
+            });
+            return combine(std::move(first_out), std::move(second_out));
+        }
+        std::unique_ptr<To1> first_out;
+        std::unique_ptr<To2> second_out;
+        run_concurrently([&]() {
+            _transform_cost[0].measure([&]() {
+                first_out.reset(new To1(this->_first->transform(sample)));
+            });
+        }, [&]() {
+            _transform_cost[1].measure([&]() {
+                second_out.reset(new To2(this->_second->transform(sample)));
+            });
+        });
+        return combine(std::move(*first_out), std::move(*second_out));
+    }
+
+    std::vector<CombineT> transform_batch_branches(const From* first,
+            size_t n, std::vector<From>* owned) const {
+        if (n == 0) {
+            return std::vector<CombineT>();
+        }
+        std::vector<To1> first_out;
+        std::vector<To2> second_out;
+        auto run_first = [&]() {
+            _transform_cost[0].measure([&]() {
+                first_out = this->_first->transform_batch(first, n);
+            }, n);
+        };
+        if (worth_parallel(_transform_cost, n)) {
+            run_concurrently(run_first, [&]() {
+                _transform_cost[1].measure([&]() {
+                    second_out = this->_second->transform_batch(first, n);
+                }, n);
+            });
+        } else {
+            run_first();
+            _transform_cost[1].measure([&]() {
+                second_out = owned ?
+                    this->_second->transform_batch(std::move(*owned)) :
+                    this->_second->transform_batch(first, n);
+            }, n);
+        }
+        return this->combine_batch(std::move(first_out),
+                std::move(second_out));
+    }
+
+    /**
+     * Run func1 on the pool and func2 here, and wait for both.
+     */
+    template<typename Func1, typename Func2>
+    void run_concurrently(Func1 func1, Func2 func2) const {
+        auto task = _pool->submit(func1);
+        try {
+            func2();
+        } catch (...) {
+            // The task refers to our caller's locals, it has to finish first.
+            try {
+                task->wait();
+            } catch (...) {}
+            throw;
+        }
+        task->wait();
+    }
+
+    bool worth_parallel(const CostEstimate* costs, size_t rows = 1) const {
+        return costs[0].get() * rows >= _min_parallel_nanos &&
+            costs[1].get() * rows >= _min_parallel_nanos;
+    }
+
+    std::shared_ptr<ThreadPool> _pool;
+    double _min_parallel_nanos;
+    CostEstimate _step_cost[2];
+    mutable CostEstimate _transform_cost[2];
+};
+
+/**
+ * Opt-in counterpart of operator| that may run the branches concurrently on
+ * pool.
+ */
+template<typename From, typename To1, typename To2>
+std::shared_ptr<Transformer<From, decltype(combine(To1(), To2()))>>
+make_parallel_combiner(std::shared_ptr<Transformer<From, To1>> first,
+        std::shared_ptr<Transformer<From, To2>> second,
+        std::shared_ptr<ThreadPool> pool,
+        double min_parallel_nanos = 20000) {
+    using CombineT = decltype(combine(To1(), To2()));
+    return std::shared_ptr<Transformer<From, CombineT>>(
+            new ParallelCombiner<From, To1, To2>(first, second,
+                std::move(pool), min_parallel_nanos));
+}
+} // namespace: transformer
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * QuantileBinner: equal-frequency binning (discretization) of a numeric
+ * feature.
+ *
+ * The cut points are quantiles of the feature across all samples. Exact
+ * quantiles would need to keep every value, so step feeds a KllSketch
+ * instead: fixed memory, and mergeable when shards are fitted by different
+ * threads. finalize turns the sketch into num_bins - 1 cut points (fewer when
+ * some coincide, e.g. for a feature with few distinct values).
+ *
+ * Value x goes to bin i when it is at or above i of the cut points. Output
+ * is either the bin number (To = int) or a one-hot SparseVector over bins.
+ */
+#ifndef FASTFEA_QUANTILE_BINNER_H
+#define FASTFEA_QUANTILE_BINNER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "simd.hpp"
+#include "sketch.hpp"
+#include "sparse.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+template<typename To>
+struct BinOutput;
+
+template<>
+struct BinOutput<int> {
+    static int make(size_t bin, size_t) {
+        return static_cast<int>(bin);
+    }
+
+    static size_t dim(size_t) {
+        return 1;
+    }
+};
+
+template<typename T>
+struct BinOutput<SparseVector<T>> {
+    static SparseVector<T> make(size_t bin, size_t num_bins) {
+        SparseVector<T> output(num_bins);
+        output.push_back(static_cast<uint32_t>(bin), 1);
+        return output;
+    }
+
+    static size_t dim(size_t num_bins) {
+        return num_bins;
+    }
+};
+
+template<typename To = int>
+class QuantileBinner : public Transformer<double, To> {
+public:
+    /**
+     * sketch_k trades memory for accuracy of the cut points, see KllSketch.
+     */
+    explicit QuantileBinner(size_t num_bins = 10, size_t sketch_k = 200) :
+            _num_bins(std::max<size_t>(num_bins, 1)), _sketch(sketch_k) {
+        this->_is_finalized = false;
+    }
+
+    virtual void step(const double& sample) {
+        _sketch.push(sample);
+    }
+
+    /**
+     * Fold in the sketch of a QuantileBinner fitted on other samples.
+     */
+    void merge(const QuantileBinner& other) {
+        _sketch.merge(other._sketch);
+    }
+
+    virtual void finalize() {
+        std::vector<double> ranks;
+        for (size_t i = 1; i < _num_bins; i++) {
+            ranks.push_back(static_cast<double>(i) / _num_bins);
+        }
+        _boundaries.clear();
+        if (_sketch.count() > 0) {
+            _boundaries = _sketch.quantiles(ranks);
+            _boundaries.erase(std::unique(_boundaries.begin(),
+                        _boundaries.end()), _boundaries.end());
+            // A cut at the minimum would leave bin 0 empty.
+            double min = _sketch.quantile(0);
+            _boundaries.erase(std::remove(_boundaries.begin(),
+                        _boundaries.end(), min), _boundaries.end());
+        }
+        _eytzinger.assign(_boundaries.size() + 1, 0);
+        _rank.assign(_boundaries.size() + 1, 0);
+        build_eytzinger(0, 1);
+        this->_is_finalized = true;
+    }
+
+    /**
+     * Further samples go into the same sketch, the next finalize recomputes
+     * the cut points over all samples.
+     */
+    virtual void extend() {
+        this->_is_finalized = false;
+    }
+
+    size_t num_bins() const {
+        return _boundaries.size() + 1;
+    }
+
+    virtual size_t output_dim() const {
+        return BinOutput<To>::dim(num_bins());
+    }
+
+    const std::vector<double>& boundaries() const {
+        return _boundaries;
+    }
+
+    size_t bin(double x) const {
+        size_t size = _boundaries.size();
+        // A handful of cut points are compared at once, more are searched in
+        // the Eytzinger layout.
+        if (size <= kLinearSearchMax) {
+            return simd::count_less_equal(_boundaries.data(), size, x);
+        }
+        // Branch-free descent: go right when the node is <= x. The first
+        // node > x is where we last went left, i.e. strip the trailing ones
+        // and one more bit. None (all right turns) means above every cut.
+        uint64_t k = 1;
+        while (k <= size) {
+            k = 2 * k + (_eytzinger[k] <= x);
+        }
+        k >>= count_trailing_ones(k) + 1;
+        return k == 0 ? size : _rank[k];
+    }
+
+    virtual To transform(const double& sample) const {
+        return BinOutput<To>::make(bin(sample), num_bins());
+    }
+
+    using Transformer<double, To>::transform_batch;
+
+    virtual std::vector<To> transform_batch(const double* first,
+            size_t n) const {
+        size_t bins = num_bins();
+        std::vector<To> output;
+        output.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            output.push_back(BinOutput<To>::make(bin(first[i]), bins));
+        }
+        return output;
+    }
+
+    virtual std::shared_ptr<Transformer<double, To>> clone() const {
+        return std::make_shared<QuantileBinner>(*this);
+    }
+
+private:
+    static const size_t kLinearSearchMax = 32;
+
+    static unsigned count_trailing_ones(uint64_t k) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(~k);
+#else
+        unsigned count = 0;
+        for (; k & 1; k >>= 1) {
+            count++;
+        }
+        return count;
+#endif
+    }
+
+    // Lay out the sorted boundaries in BFS order of a complete binary search
+    // tree (node k has children 2k and 2k+1), so the first levels of every
+    // search share the same few cache lines.
+    size_t build_eytzinger(size_t i, size_t k) {
+        if (k <= _boundaries.size()) {
+            i = build_eytzinger(i, 2 * k);
+            _eytzinger[k] = _boundaries[i];
+            _rank[k] = i++;
+            i = build_eytzinger(i, 2 * k + 1);
+        }
+        return i;
+    }
+
+    size_t _num_bins;
+    KllSketch _sketch;
+    std::vector<double> _boundaries;
+    std::vector<double> _eytzinger;
+    std::vector<size_t> _rank;
+};
+} // namespace: transformer
+
+#endif
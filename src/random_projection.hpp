@@ -0,0 +1,141 @@
+/**
+ * RandomProjection: reduce wide vectors (e.g. concatenated one-hot codes) to
+ * a fixed, small number of dimensions, roughly preserving distances
+ * (Johnson-Lindenstrauss).
+ *
+ * The projection is a sparse random matrix (Achlioptas 2003): each entry is
+ * +s or -s with probability density / 2 each, 0 otherwise, with
+ * s = 1 / sqrt(density * output_dim) so that norms are preserved on average.
+ * density = 1/3 is Achlioptas' choice; lower is faster and noisier.
+ *
+ * The matrix is never stored: row i (what input dimension i adds to the
+ * output) is regenerated from a hash of (seed, i) when needed, so memory
+ * doesn't depend on the input width, which needn't even be known. Only the
+ * non-zeros of the input cost anything: each adds its row times its value to
+ * the output with a vectorized kernel. transform_batch regenerates each row
+ * once for the whole batch.
+ */
+#ifndef FASTFEA_RANDOM_PROJECTION_H
+#define FASTFEA_RANDOM_PROJECTION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "arena.hpp"
+#include "hasher.hpp"
+#include "simd.hpp"
+#include "sparse.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+/**
+ * From is std::vector<double> or SparseVector<double>; either way the
+ * output is dense, with output_dim dimensions.
+ */
+template<typename From>
+class RandomProjection : public Transformer<From, std::vector<double>> {
+public:
+    explicit RandomProjection(size_t output_dim, double density = 1.0 / 3,
+            uint64_t seed = 0) : _output_dim(output_dim), _seed(seed) {
+        if (output_dim == 0) {
+            throw std::invalid_argument("RandomProjection: no output");
+        }
+        if (!(density > 0 && density <= 1)) {
+            throw std::invalid_argument(
+                    "RandomProjection: density not in (0, 1]");
+        }
+        // Each entry comes from a byte of hash: below the threshold it's
+        // +1, below twice the threshold -1.
+        _threshold = std::max<unsigned>(1, static_cast<unsigned>(
+                    std::lround(density * 128)));
+        _scale = 1 / std::sqrt(_threshold / 128.0 * output_dim);
+    }
+
+    virtual std::vector<double> transform(const From& sample) const {
+        std::vector<double> output(_output_dim);
+        ArenaScope scope;
+        ArenaVector<double> row = scope.vector<double>();
+        row.resize(_output_dim);
+        for_each_nonzero(sample, [&](size_t index, double value) {
+            make_row(index, row.data());
+            simd::axpy(row.data(), output.data(), _output_dim,
+                    value * _scale);
+        });
+        return output;
+    }
+
+    /**
+     * Gather the non-zeros of all samples by input dimension, so that each
+     * row is generated once.
+     */
+    using Transformer<From, std::vector<double>>::transform_batch;
+
+    virtual std::vector<std::vector<double>> transform_batch(
+            const From* first, size_t n) const {
+        ArenaScope scope;
+        // Counted first, so that the entries take no more arena than needed
+        // rather than up to twice as much from growing.
+        size_t num_entries = 0;
+        for (size_t s = 0; s < n; s++) {
+            for_each_nonzero(first[s], [&](size_t, double) { num_entries++; });
+        }
+        auto entries = scope.vector<std::tuple<size_t, size_t, double>>();
+        entries.reserve(num_entries);
+        for (size_t s = 0; s < n; s++) {
+            for_each_nonzero(first[s], [&](size_t index, double value) {
+                entries.emplace_back(index, s, value);
+            });
+        }
+        std::sort(entries.begin(), entries.end());
+        std::vector<std::vector<double>> output(n,
+                std::vector<double>(_output_dim));
+        ArenaVector<double> row = scope.vector<double>();
+        row.resize(_output_dim);
+        for (size_t e = 0; e < entries.size(); e++) {
+            size_t index = std::get<0>(entries[e]);
+            if (e == 0 || index != std::get<0>(entries[e - 1])) {
+                make_row(index, row.data());
+            }
+            simd::axpy(row.data(), output[std::get<1>(entries[e])].data(),
+                    _output_dim, std::get<2>(entries[e]) * _scale);
+        }
+        return output;
+    }
+
+    virtual size_t output_dim() const {
+        return _output_dim;
+    }
+
+    virtual std::shared_ptr<Transformer<From, std::vector<double>>>
+    clone() const {
+        return std::make_shared<RandomProjection>(*this);
+    }
+
+private:
+    // Row of input dimension index, in units of the scale: +1, -1 or 0.
+    void make_row(size_t index, double* row) const {
+        uint64_t row_hash = mix_hash(_seed, index);
+        for (size_t j = 0; j < _output_dim; j += 8) {
+            uint64_t bits = mix_hash(row_hash, j);
+            size_t end = std::min(_output_dim, j + 8);
+            for (size_t k = j; k < end; k++, bits >>= 8) {
+                unsigned byte = bits & 0xff;
+                row[k] = byte < _threshold ? 1 :
+                    byte < 2 * _threshold ? -1 : 0;
+            }
+        }
+    }
+
+    size_t _output_dim;
+    uint64_t _seed;
+    unsigned _threshold;
+    double _scale;
+};
+} // namespace: transformer
+
+#endif
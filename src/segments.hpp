@@ -0,0 +1,218 @@
+/**
+ * Segments: a vector made of owned chunks, for concatenating wide outputs.
+ *
+ * combine() of two std::vector copies the second one's elements after the
+ * first one's, and a nest of combiners (A | B | C | ...) copies each element
+ * once per level. Combining Segments moves whole chunks instead: no element
+ * is copied until the sink gathers them, once, into its own buffer (e.g. a
+ * row of DenseMatrixWriter).
+ *
+ * segmented(t) turns the std::vector output of t into Segments; the
+ * std::vector outputs it is combined with join as chunks:
+ *
+ *   segmented(A) | B | C  -->  Segments of three chunks
+ */
+#ifndef FASTFEA_SEGMENTS_H
+#define FASTFEA_SEGMENTS_H
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "transformer.hpp"
+
+namespace transformer {
+
+template<typename T>
+class Segments {
+public:
+    Segments() {}
+    explicit Segments(std::vector<T>&& segment) {
+        append(std::move(segment));
+    }
+
+    void append(std::vector<T>&& segment) {
+        if (!segment.empty()) {
+            _size += segment.size();
+            _segments.push_back(std::move(segment));
+        }
+    }
+
+    void append(Segments&& other) {
+        _size += other._size;
+        for (auto& segment : other._segments) {
+            _segments.push_back(std::move(segment));
+        }
+        other._segments.clear();
+        other._size = 0;
+    }
+
+    /**
+     * Number of elements, over all segments.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    const std::vector<std::vector<T>>& segments() const {
+        return _segments;
+    }
+
+    /**
+     * Copy the elements into out (size() of them), converting to U.
+     */
+    template<typename U>
+    void gather(U* out) const {
+        for (const auto& segment : _segments) {
+            out = std::copy(segment.begin(), segment.end(), out);
+        }
+    }
+
+    std::vector<T> to_vector() const {
+        std::vector<T> output(_size);
+        gather(output.data());
+        return output;
+    }
+
+    bool operator==(const Segments& other) const {
+        return _size == other._size && to_vector() == other.to_vector();
+    }
+
+    bool operator!=(const Segments& other) const {
+        return !(*this == other);
+    }
+
+private:
+    std::vector<std::vector<T>> _segments;
+    size_t _size = 0;
+};
+
+template<typename T>
+Segments<T> combine(Segments<T>&& first_out, Segments<T>&& second_out) {
+    Segments<T> out(std::move(first_out));
+    out.append(std::move(second_out));
+    return out;
+}
+
+template<typename T>
+Segments<T> combine(Segments<T>&& first_out, std::vector<T>&& second_out) {
+    Segments<T> out(std::move(first_out));
+    out.append(std::move(second_out));
+    return out;
+}
+
+template<typename T>
+Segments<T> combine(std::vector<T>&& first_out, Segments<T>&& second_out) {
+    Segments<T> out(std::move(first_out));
+    out.append(std::move(second_out));
+    return out;
+}
+
+/**
+ * Call func(index, value) on the non-zeros, in index order.
+ */
+template<typename T, typename Func>
+void for_each_nonzero(const Segments<T>& vector, Func func) {
+    size_t offset = 0;
+    for (const auto& segment : vector.segments()) {
+        for (size_t i = 0; i < segment.size(); i++) {
+            if (segment[i] != 0) {
+                func(offset + i, segment[i]);
+            }
+        }
+        offset += segment.size();
+    }
+}
+
+/**
+ * The output of a transformer, moved into a single segment. Fitting goes
+ * to the wrapped transformer.
+ */
+template<typename From, typename T>
+class SegmentedTransformer : public Transformer<From, Segments<T>> {
+public:
+    explicit SegmentedTransformer(
+            std::shared_ptr<Transformer<From, std::vector<T>>> inner) :
+            _inner(std::move(inner)) {
+        this->_is_finalized = _inner->is_finalized();
+    }
+
+    SegmentedTransformer(const SegmentedTransformer& other) :
+            Transformer<From, Segments<T>>(other),
+            _inner(other._inner->clone()) {}
+    SegmentedTransformer(SegmentedTransformer&&) = default;
+
+    virtual void step(const From& sample) {
+        _inner->step(sample);
+    }
+
+    virtual void step(From&& sample) {
+        _inner->step(std::move(sample));
+    }
+
+    virtual void step_batch(const std::vector<From>& samples) {
+        _inner->step_batch(samples);
+    }
+
+    virtual void finalize() {
+        _inner->finalize();
+        this->_is_finalized = true;
+    }
+
+    virtual void extend() {
+        _inner->extend();
+        this->_is_finalized = _inner->is_finalized();
+    }
+
+    virtual Segments<T> transform(const From& sample) const {
+        return Segments<T>(_inner->transform(sample));
+    }
+
+    virtual Segments<T> transform(From&& sample) {
+        return Segments<T>(_inner->transform(std::move(sample)));
+    }
+
+    using Transformer<From, Segments<T>>::transform_batch;
+
+    virtual std::vector<Segments<T>> transform_batch(const From* first,
+            size_t n) const {
+        return to_segments(_inner->transform_batch(first, n));
+    }
+
+    virtual std::vector<Segments<T>> transform_batch(
+            std::vector<From>&& samples) {
+        return to_segments(_inner->transform_batch(std::move(samples)));
+    }
+
+    virtual size_t output_dim() const {
+        return _inner->output_dim();
+    }
+
+    virtual std::shared_ptr<Transformer<From, Segments<T>>> clone() const {
+        return std::make_shared<SegmentedTransformer>(*this);
+    }
+
+private:
+    static std::vector<Segments<T>> to_segments(
+            std::vector<std::vector<T>>&& outputs) {
+        std::vector<Segments<T>> output;
+        output.reserve(outputs.size());
+        for (auto& vector : outputs) {
+            output.emplace_back(std::move(vector));
+        }
+        return output;
+    }
+
+    std::shared_ptr<Transformer<From, std::vector<T>>> _inner;
+};
+
+template<typename From, typename T>
+std::shared_ptr<Transformer<From, Segments<T>>> segmented(
+        std::shared_ptr<Transformer<From, std::vector<T>>> transformer) {
+    return std::make_shared<SegmentedTransformer<From, T>>(
+            std::move(transformer));
+}
+} // namespace: transformer
+
+#endif
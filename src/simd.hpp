@@ -0,0 +1,1080 @@
+/**
+ * Vectorized kernels over contiguous arrays, with runtime CPU dispatch.
+ *
+ * Every kernel has a portable scalar version and, on x86 with GCC or clang,
+ * versions compiled for SSE4/AVX2/AVX-512 through target attributes. The best
+ * one the running CPU supports is picked at run time, so a single binary
+ * built without -march flags still uses AVX-512 where there is one.
+ *
+ * Kernels don't use FMA, so every level computes bit-identical results (the
+ * same operations, in the same order, as the scalar version).
+ */
+#ifndef FASTFEA_SIMD_H
+#define FASTFEA_SIMD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FASTFEA_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define FASTFEA_SIMD_X86 0
+#endif
+
+namespace transformer {
+namespace simd {
+
+enum class Level {
+    Scalar = 0,
+    SSE4 = 1,
+    AVX2 = 2,
+    AVX512 = 3,
+};
+
+/**
+ * Best level supported by the CPU (and the OS) we're running on.
+ */
+inline Level detect_level() {
+#if FASTFEA_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return Level::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return Level::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return Level::SSE4;
+    }
+#endif
+    return Level::Scalar;
+}
+
+namespace detail {
+inline Level& active_level() {
+    static Level level = detect_level();
+    return level;
+}
+}
+
+/**
+ * Level the kernels dispatch to.
+ */
+inline Level level() {
+    return detail::active_level();
+}
+
+/**
+ * Restrict kernels to at most the given level, e.g. to compare levels in
+ * tests and benchmarks. Not thread-safe, call it before using any kernel.
+ */
+inline void set_level(Level level) {
+    detail::active_level() = std::min(level, detect_level());
+}
+
+namespace detail {
+
+inline void affine_scalar(const double* in, double* out, size_t n,
+        double scale, double shift) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = in[i] * scale + shift;
+    }
+}
+
+inline void affine_scalar(const float* in, float* out, size_t n,
+        float scale, float shift) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = in[i] * scale + shift;
+    }
+}
+
+inline void affine_columns_scalar(const double* in, double* out, size_t n,
+        const double* scale, const double* shift) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = in[i] * scale[i] + shift[i];
+    }
+}
+
+inline void affine_columns_scalar(const float* in, float* out, size_t n,
+        const float* scale, const float* shift) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = in[i] * scale[i] + shift[i];
+    }
+}
+
+inline size_t count_less_equal_scalar(const double* values, size_t n,
+        double x) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += values[i] <= x;
+    }
+    return count;
+}
+
+#if FASTFEA_SIMD_X86
+__attribute__((target("sse4.1")))
+inline void affine_sse4(const double* in, double* out, size_t n,
+        double scale, double shift) {
+    __m128d s = _mm_set1_pd(scale);
+    __m128d b = _mm_set1_pd(shift);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(in + i);
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(x, s), b));
+    }
+    affine_scalar(in + i, out + i, n - i, scale, shift);
+}
+
+__attribute__((target("avx2")))
+inline void affine_avx2(const double* in, double* out, size_t n,
+        double scale, double shift) {
+    __m256d s = _mm256_set1_pd(scale);
+    __m256d b = _mm256_set1_pd(shift);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d x0 = _mm256_loadu_pd(in + i);
+        __m256d x1 = _mm256_loadu_pd(in + i + 4);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(x0, s), b));
+        _mm256_storeu_pd(out + i + 4, _mm256_add_pd(_mm256_mul_pd(x1, s), b));
+    }
+    affine_scalar(in + i, out + i, n - i, scale, shift);
+}
+
+__attribute__((target("avx512f")))
+inline void affine_avx512(const double* in, double* out, size_t n,
+        double scale, double shift) {
+    __m512d s = _mm512_set1_pd(scale);
+    __m512d b = _mm512_set1_pd(shift);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d x = _mm512_loadu_pd(in + i);
+        _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_mul_pd(x, s), b));
+    }
+    if (i < n) {
+        __mmask8 mask = (__mmask8)((1u << (n - i)) - 1);
+        __m512d x = _mm512_maskz_loadu_pd(mask, in + i);
+        _mm512_mask_storeu_pd(out + i, mask,
+                _mm512_add_pd(_mm512_mul_pd(x, s), b));
+    }
+}
+
+__attribute__((target("sse4.1")))
+inline void affine_sse4(const float* in, float* out, size_t n,
+        float scale, float shift) {
+    __m128 s = _mm_set1_ps(scale);
+    __m128 b = _mm_set1_ps(shift);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(in + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(x, s), b));
+    }
+    affine_scalar(in + i, out + i, n - i, scale, shift);
+}
+
+__attribute__((target("avx2")))
+inline void affine_avx2(const float* in, float* out, size_t n,
+        float scale, float shift) {
+    __m256 s = _mm256_set1_ps(scale);
+    __m256 b = _mm256_set1_ps(shift);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 x0 = _mm256_loadu_ps(in + i);
+        __m256 x1 = _mm256_loadu_ps(in + i + 8);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(x0, s), b));
+        _mm256_storeu_ps(out + i + 8, _mm256_add_ps(_mm256_mul_ps(x1, s), b));
+    }
+    affine_scalar(in + i, out + i, n - i, scale, shift);
+}
+
+__attribute__((target("avx512f")))
+inline void affine_avx512(const float* in, float* out, size_t n,
+        float scale, float shift) {
+    __m512 s = _mm512_set1_ps(scale);
+    __m512 b = _mm512_set1_ps(shift);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_loadu_ps(in + i);
+        _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_mul_ps(x, s), b));
+    }
+    if (i < n) {
+        __mmask16 mask = (__mmask16)((1u << (n - i)) - 1);
+        __m512 x = _mm512_maskz_loadu_ps(mask, in + i);
+        _mm512_mask_storeu_ps(out + i, mask,
+                _mm512_add_ps(_mm512_mul_ps(x, s), b));
+    }
+}
+
+__attribute__((target("sse4.1")))
+inline void affine_columns_sse4(const double* in, double* out, size_t n,
+        const double* scale, const double* shift) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(in + i);
+        _mm_storeu_pd(out + i, _mm_add_pd(
+                    _mm_mul_pd(x, _mm_loadu_pd(scale + i)),
+                    _mm_loadu_pd(shift + i)));
+    }
+    affine_columns_scalar(in + i, out + i, n - i, scale + i, shift + i);
+}
+
+__attribute__((target("avx2")))
+inline void affine_columns_avx2(const double* in, double* out, size_t n,
+        const double* scale, const double* shift) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(in + i);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(
+                    _mm256_mul_pd(x, _mm256_loadu_pd(scale + i)),
+                    _mm256_loadu_pd(shift + i)));
+    }
+    affine_columns_scalar(in + i, out + i, n - i, scale + i, shift + i);
+}
+
+__attribute__((target("avx512f")))
+inline void affine_columns_avx512(const double* in, double* out, size_t n,
+        const double* scale, const double* shift) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d x = _mm512_loadu_pd(in + i);
+        _mm512_storeu_pd(out + i, _mm512_add_pd(
+                    _mm512_mul_pd(x, _mm512_loadu_pd(scale + i)),
+                    _mm512_loadu_pd(shift + i)));
+    }
+    if (i < n) {
+        __mmask8 mask = (__mmask8)((1u << (n - i)) - 1);
+        __m512d x = _mm512_maskz_loadu_pd(mask, in + i);
+        _mm512_mask_storeu_pd(out + i, mask, _mm512_add_pd(
+                    _mm512_mul_pd(x, _mm512_maskz_loadu_pd(mask, scale + i)),
+                    _mm512_maskz_loadu_pd(mask, shift + i)));
+    }
+}
+
+__attribute__((target("sse4.1")))
+inline void affine_columns_sse4(const float* in, float* out, size_t n,
+        const float* scale, const float* shift) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(in + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(
+                    _mm_mul_ps(x, _mm_loadu_ps(scale + i)),
+                    _mm_loadu_ps(shift + i)));
+    }
+    affine_columns_scalar(in + i, out + i, n - i, scale + i, shift + i);
+}
+
+__attribute__((target("avx2")))
+inline void affine_columns_avx2(const float* in, float* out, size_t n,
+        const float* scale, const float* shift) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(in + i);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(
+                    _mm256_mul_ps(x, _mm256_loadu_ps(scale + i)),
+                    _mm256_loadu_ps(shift + i)));
+    }
+    affine_columns_scalar(in + i, out + i, n - i, scale + i, shift + i);
+}
+
+__attribute__((target("avx512f")))
+inline void affine_columns_avx512(const float* in, float* out, size_t n,
+        const float* scale, const float* shift) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_loadu_ps(in + i);
+        _mm512_storeu_ps(out + i, _mm512_add_ps(
+                    _mm512_mul_ps(x, _mm512_loadu_ps(scale + i)),
+                    _mm512_loadu_ps(shift + i)));
+    }
+    if (i < n) {
+        __mmask16 mask = (__mmask16)((1u << (n - i)) - 1);
+        __m512 x = _mm512_maskz_loadu_ps(mask, in + i);
+        _mm512_mask_storeu_ps(out + i, mask, _mm512_add_ps(
+                    _mm512_mul_ps(x, _mm512_maskz_loadu_ps(mask, scale + i)),
+                    _mm512_maskz_loadu_ps(mask, shift + i)));
+    }
+}
+
+// SSE4.1 doesn't imply POPCNT (it came with SSE4.2), two bits are easy
+// enough to count by hand.
+__attribute__((target("sse4.1")))
+inline size_t count_less_equal_sse4(const double* values, size_t n,
+        double x) {
+    __m128d v = _mm_set1_pd(x);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        int mask = _mm_movemask_pd(_mm_cmple_pd(_mm_loadu_pd(values + i), v));
+        count += (mask & 1) + (mask >> 1);
+    }
+    return count + count_less_equal_scalar(values + i, n - i, x);
+}
+
+__attribute__((target("avx2,popcnt")))
+inline size_t count_less_equal_avx2(const double* values, size_t n,
+        double x) {
+    __m256d v = _mm256_set1_pd(x);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        count += _mm_popcnt_u32(_mm256_movemask_pd(_mm256_cmp_pd(
+                        _mm256_loadu_pd(values + i), v, _CMP_LE_OQ)));
+    }
+    return count + count_less_equal_scalar(values + i, n - i, x);
+}
+
+__attribute__((target("avx512f,popcnt")))
+inline size_t count_less_equal_avx512(const double* values, size_t n,
+        double x) {
+    __m512d v = _mm512_set1_pd(x);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        count += _mm_popcnt_u32(_mm512_cmp_pd_mask(
+                    _mm512_loadu_pd(values + i), v, _CMP_LE_OQ));
+    }
+    if (i < n) {
+        __mmask8 mask = (__mmask8)((1u << (n - i)) - 1);
+        count += _mm_popcnt_u32(_mm512_mask_cmp_pd_mask(mask,
+                    _mm512_maskz_loadu_pd(mask, values + i), v, _CMP_LE_OQ));
+    }
+    return count;
+}
+#endif
+}
+
+/**
+ * out[i] = in[i] * scale + shift. in and out may be the same array.
+ */
+inline void affine(const double* in, double* out, size_t n,
+        double scale, double shift) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+        return detail::affine_avx512(in, out, n, scale, shift);
+    case Level::AVX2:
+        return detail::affine_avx2(in, out, n, scale, shift);
+    case Level::SSE4:
+        return detail::affine_sse4(in, out, n, scale, shift);
+    default:
+        break;
+    }
+#endif
+    detail::affine_scalar(in, out, n, scale, shift);
+}
+
+/**
+ * The same for float, twice as many per instruction.
+ */
+inline void affine(const float* in, float* out, size_t n,
+        float scale, float shift) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+        return detail::affine_avx512(in, out, n, scale, shift);
+    case Level::AVX2:
+        return detail::affine_avx2(in, out, n, scale, shift);
+    case Level::SSE4:
+        return detail::affine_sse4(in, out, n, scale, shift);
+    default:
+        break;
+    }
+#endif
+    detail::affine_scalar(in, out, n, scale, shift);
+}
+
+/**
+ * out[i] = in[i] * scale[i] + shift[i]. in and out may be the same array.
+ */
+inline void affine_columns(const double* in, double* out, size_t n,
+        const double* scale, const double* shift) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+        return detail::affine_columns_avx512(in, out, n, scale, shift);
+    case Level::AVX2:
+        return detail::affine_columns_avx2(in, out, n, scale, shift);
+    case Level::SSE4:
+        return detail::affine_columns_sse4(in, out, n, scale, shift);
+    default:
+        break;
+    }
+#endif
+    detail::affine_columns_scalar(in, out, n, scale, shift);
+}
+
+/**
+ * The same for float columns, twice as many per instruction.
+ */
+inline void affine_columns(const float* in, float* out, size_t n,
+        const float* scale, const float* shift) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+        return detail::affine_columns_avx512(in, out, n, scale, shift);
+    case Level::AVX2:
+        return detail::affine_columns_avx2(in, out, n, scale, shift);
+    case Level::SSE4:
+        return detail::affine_columns_sse4(in, out, n, scale, shift);
+    default:
+        break;
+    }
+#endif
+    detail::affine_columns_scalar(in, out, n, scale, shift);
+}
+
+/**
+ * Number of values that are <= x; NaN compares false. Meant for short
+ * arrays, e.g. bin boundaries.
+ */
+inline size_t count_less_equal(const double* values, size_t n, double x) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+        return detail::count_less_equal_avx512(values, n, x);
+    case Level::AVX2:
+        return detail::count_less_equal_avx2(values, n, x);
+    case Level::SSE4:
+        return detail::count_less_equal_sse4(values, n, x);
+    default:
+        break;
+    }
+#endif
+    return detail::count_less_equal_scalar(values, n, x);
+}
+
+namespace detail {
+
+inline void clip_scalar(const double* in, double* out, size_t n,
+        double lower, double upper) {
+    for (size_t i = 0; i < n; i++) {
+        // Same operand order as the min/max instructions: NaN goes through.
+        double x = lower > in[i] ? lower : in[i];
+        out[i] = upper < x ? upper : x;
+    }
+}
+
+inline void clip_scalar(const float* in, float* out, size_t n,
+        float lower, float upper) {
+    for (size_t i = 0; i < n; i++) {
+        float x = lower > in[i] ? lower : in[i];
+        out[i] = upper < x ? upper : x;
+    }
+}
+
+// log1p after fdlibm's s_log1p.c: with u = 1 + x = 2^k * m, m in
+// [sqrt(2)/2, sqrt(2)), log1p(x) = k * ln2 + log(m) + c, c correcting the
+// rounding of 1 + x. log(m) is 2s + s * R(s^2), s = (m - 1) / (m + 1), R a
+// minimax polynomial. Error below 1 ulp.
+const double kLn2Hi = 6.93147180369123816490e-01;
+const double kLn2Lo = 1.90821492927058770002e-10;
+const double kLg1 = 6.666666666666735130e-01;
+const double kLg2 = 3.999999999940941908e-01;
+const double kLg3 = 2.857142874366239149e-01;
+const double kLg4 = 2.222219843214978396e-01;
+const double kLg5 = 1.818357216161805012e-01;
+const double kLg6 = 1.531383769920937332e-01;
+const double kLg7 = 1.479819860511658591e-01;
+// Moves the exponent boundary from 1 to sqrt(2)/2 (high word of its bits).
+const uint64_t kSqrtHalfBits = 0x3fe6a09e00000000ULL;
+const uint64_t kOneBits = 0x3ff0000000000000ULL;
+const uint64_t kMantissaMask = 0x000fffffffffffffULL;
+// Or-ing a small integer into the bits of 2^52 and subtracting 2^52 converts
+// it to double, which AVX2 has no instruction for.
+const uint64_t kTwo52Bits = 0x4330000000000000ULL;
+const double kTwo52 = 4503599627370496.0;
+
+/**
+ * Inputs log1p_body can't handle, left to std::log1p.
+ */
+inline bool log1p_special(double x) {
+    return !(x > -1) || x == HUGE_VAL;
+}
+
+inline double log1p_body(double x) {
+    double u = 1 + x;
+    double c = u >= 2 ? 1 - (u - x) : x - (u - 1);
+    c = c / u;
+    uint64_t bits;
+    std::memcpy(&bits, &u, sizeof(bits));
+    bits += kOneBits - kSqrtHalfBits;
+    uint64_t exponent_bits = (bits >> 52) | kTwo52Bits;
+    double exponent;
+    std::memcpy(&exponent, &exponent_bits, sizeof(exponent));
+    double k = (exponent - kTwo52) - 1023;
+    bits = (bits & kMantissaMask) + kSqrtHalfBits;
+    double m;
+    std::memcpy(&m, &bits, sizeof(m));
+    double f = m - 1;
+    double hfsq = 0.5 * f * f;
+    double s = f / (2 + f);
+    double z = s * s;
+    double r = z * (kLg1 + z * (kLg2 + z * (kLg3 + z * (kLg4 +
+                        z * (kLg5 + z * (kLg6 + z * kLg7))))));
+    return k * kLn2Hi - ((hfsq - (s * (hfsq + r) + (k * kLn2Lo + c))) - f);
+}
+
+inline double log1p_scalar(double x) {
+    return log1p_special(x) ? std::log1p(x) : log1p_body(x);
+}
+
+inline void log1p_scalar(const double* in, double* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = log1p_scalar(in[i]);
+    }
+}
+
+#if FASTFEA_SIMD_X86
+__attribute__((target("sse4.1")))
+inline void clip_sse4(const double* in, double* out, size_t n,
+        double lower, double upper) {
+    __m128d lo = _mm_set1_pd(lower);
+    __m128d hi = _mm_set1_pd(upper);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_max_pd(lo, _mm_loadu_pd(in + i));
+        _mm_storeu_pd(out + i, _mm_min_pd(hi, x));
+    }
+    clip_scalar(in + i, out + i, n - i, lower, upper);
+}
+
+__attribute__((target("avx2")))
+inline void clip_avx2(const double* in, double* out, size_t n,
+        double lower, double upper) {
+    __m256d lo = _mm256_set1_pd(lower);
+    __m256d hi = _mm256_set1_pd(upper);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_max_pd(lo, _mm256_loadu_pd(in + i));
+        _mm256_storeu_pd(out + i, _mm256_min_pd(hi, x));
+    }
+    clip_scalar(in + i, out + i, n - i, lower, upper);
+}
+
+__attribute__((target("avx512f")))
+inline void clip_avx512(const double* in, double* out, size_t n,
+        double lower, double upper) {
+    __m512d lo = _mm512_set1_pd(lower);
+    __m512d hi = _mm512_set1_pd(upper);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d x = _mm512_max_pd(lo, _mm512_loadu_pd(in + i));
+        _mm512_storeu_pd(out + i, _mm512_min_pd(hi, x));
+    }
+    clip_scalar(in + i, out + i, n - i, lower, upper);
+}
+
+__attribute__((target("sse4.1")))
+inline void clip_sse4(const float* in, float* out, size_t n,
+        float lower, float upper) {
+    __m128 lo = _mm_set1_ps(lower);
+    __m128 hi = _mm_set1_ps(upper);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_max_ps(lo, _mm_loadu_ps(in + i));
+        _mm_storeu_ps(out + i, _mm_min_ps(hi, x));
+    }
+    clip_scalar(in + i, out + i, n - i, lower, upper);
+}
+
+__attribute__((target("avx2")))
+inline void clip_avx2(const float* in, float* out, size_t n,
+        float lower, float upper) {
+    __m256 lo = _mm256_set1_ps(lower);
+    __m256 hi = _mm256_set1_ps(upper);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_max_ps(lo, _mm256_loadu_ps(in + i));
+        _mm256_storeu_ps(out + i, _mm256_min_ps(hi, x));
+    }
+    clip_scalar(in + i, out + i, n - i, lower, upper);
+}
+
+__attribute__((target("avx512f")))
+inline void clip_avx512(const float* in, float* out, size_t n,
+        float lower, float upper) {
+    __m512 lo = _mm512_set1_ps(lower);
+    __m512 hi = _mm512_set1_ps(upper);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_max_ps(lo, _mm512_loadu_ps(in + i));
+        _mm512_storeu_ps(out + i, _mm512_min_ps(hi, x));
+    }
+    clip_scalar(in + i, out + i, n - i, lower, upper);
+}
+
+// Same operations as log1p_body, two lanes at a time.
+__attribute__((target("sse4.1")))
+inline __m128d log1p_body_sse4(__m128d x) {
+    const __m128d one = _mm_set1_pd(1);
+    __m128d u = _mm_add_pd(one, x);
+    __m128d c_big = _mm_sub_pd(one, _mm_sub_pd(u, x));
+    __m128d c_small = _mm_sub_pd(x, _mm_sub_pd(u, one));
+    __m128d c = _mm_blendv_pd(c_small, c_big,
+            _mm_cmpge_pd(u, _mm_set1_pd(2)));
+    c = _mm_div_pd(c, u);
+    __m128i bits = _mm_add_epi64(_mm_castpd_si128(u),
+            _mm_set1_epi64x(kOneBits - kSqrtHalfBits));
+    __m128d exponent = _mm_castsi128_pd(_mm_or_si128(
+                _mm_srli_epi64(bits, 52), _mm_set1_epi64x(kTwo52Bits)));
+    __m128d k = _mm_sub_pd(_mm_sub_pd(exponent, _mm_set1_pd(kTwo52)),
+            _mm_set1_pd(1023));
+    __m128d m = _mm_castsi128_pd(_mm_add_epi64(
+                _mm_and_si128(bits, _mm_set1_epi64x(kMantissaMask)),
+                _mm_set1_epi64x(kSqrtHalfBits)));
+    __m128d f = _mm_sub_pd(m, one);
+    __m128d hfsq = _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(0.5), f), f);
+    __m128d s = _mm_div_pd(f, _mm_add_pd(_mm_set1_pd(2), f));
+    __m128d z = _mm_mul_pd(s, s);
+    __m128d r = _mm_set1_pd(kLg7);
+    const double lg[] = {kLg6, kLg5, kLg4, kLg3, kLg2, kLg1};
+    for (double coefficient : lg) {
+        r = _mm_add_pd(_mm_set1_pd(coefficient), _mm_mul_pd(z, r));
+    }
+    r = _mm_mul_pd(z, r);
+    __m128d inner = _mm_add_pd(_mm_mul_pd(s, _mm_add_pd(hfsq, r)),
+            _mm_add_pd(_mm_mul_pd(k, _mm_set1_pd(kLn2Lo)), c));
+    return _mm_sub_pd(_mm_mul_pd(k, _mm_set1_pd(kLn2Hi)),
+            _mm_sub_pd(_mm_sub_pd(hfsq, inner), f));
+}
+
+__attribute__((target("sse4.1")))
+inline void log1p_sse4(const double* in, double* out, size_t n) {
+    const __m128d minus_one = _mm_set1_pd(-1);
+    const __m128d inf = _mm_set1_pd(HUGE_VAL);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(in + i);
+        __m128d special = _mm_or_pd(_mm_cmpngt_pd(x, minus_one),
+                _mm_cmpeq_pd(x, inf));
+        if (_mm_movemask_pd(special)) {
+            log1p_scalar(in + i, out + i, 2);
+        } else {
+            _mm_storeu_pd(out + i, log1p_body_sse4(x));
+        }
+    }
+    log1p_scalar(in + i, out + i, n - i);
+}
+
+// Same operations as log1p_body, four lanes at a time.
+__attribute__((target("avx2")))
+inline __m256d log1p_body_avx2(__m256d x) {
+    const __m256d one = _mm256_set1_pd(1);
+    __m256d u = _mm256_add_pd(one, x);
+    __m256d c_big = _mm256_sub_pd(one, _mm256_sub_pd(u, x));
+    __m256d c_small = _mm256_sub_pd(x, _mm256_sub_pd(u, one));
+    __m256d c = _mm256_blendv_pd(c_small, c_big,
+            _mm256_cmp_pd(u, _mm256_set1_pd(2), _CMP_GE_OQ));
+    c = _mm256_div_pd(c, u);
+    __m256i bits = _mm256_add_epi64(_mm256_castpd_si256(u),
+            _mm256_set1_epi64x(kOneBits - kSqrtHalfBits));
+    __m256d exponent = _mm256_castsi256_pd(_mm256_or_si256(
+                _mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(kTwo52Bits)));
+    __m256d k = _mm256_sub_pd(_mm256_sub_pd(exponent, _mm256_set1_pd(kTwo52)),
+            _mm256_set1_pd(1023));
+    __m256d m = _mm256_castsi256_pd(_mm256_add_epi64(
+                _mm256_and_si256(bits, _mm256_set1_epi64x(kMantissaMask)),
+                _mm256_set1_epi64x(kSqrtHalfBits)));
+    __m256d f = _mm256_sub_pd(m, one);
+    __m256d hfsq = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), f), f);
+    __m256d s = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2), f));
+    __m256d z = _mm256_mul_pd(s, s);
+    __m256d r = _mm256_set1_pd(kLg7);
+    const double lg[] = {kLg6, kLg5, kLg4, kLg3, kLg2, kLg1};
+    for (double coefficient : lg) {
+        r = _mm256_add_pd(_mm256_set1_pd(coefficient), _mm256_mul_pd(z, r));
+    }
+    r = _mm256_mul_pd(z, r);
+    __m256d inner = _mm256_add_pd(_mm256_mul_pd(s, _mm256_add_pd(hfsq, r)),
+            _mm256_add_pd(_mm256_mul_pd(k, _mm256_set1_pd(kLn2Lo)), c));
+    return _mm256_sub_pd(_mm256_mul_pd(k, _mm256_set1_pd(kLn2Hi)),
+            _mm256_sub_pd(_mm256_sub_pd(hfsq, inner), f));
+}
+
+__attribute__((target("avx2")))
+inline void log1p_avx2(const double* in, double* out, size_t n) {
+    const __m256d minus_one = _mm256_set1_pd(-1);
+    const __m256d inf = _mm256_set1_pd(HUGE_VAL);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(in + i);
+        __m256d special = _mm256_or_pd(
+                _mm256_cmp_pd(x, minus_one, _CMP_NGT_UQ),
+                _mm256_cmp_pd(x, inf, _CMP_EQ_OQ));
+        if (_mm256_movemask_pd(special)) {
+            log1p_scalar(in + i, out + i, 4);
+        } else {
+            _mm256_storeu_pd(out + i, log1p_body_avx2(x));
+        }
+    }
+    log1p_scalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+inline __m512d log1p_body_avx512(__m512d x) {
+    const __m512d one = _mm512_set1_pd(1);
+    __m512d u = _mm512_add_pd(one, x);
+    __m512d c_big = _mm512_sub_pd(one, _mm512_sub_pd(u, x));
+    __m512d c_small = _mm512_sub_pd(x, _mm512_sub_pd(u, one));
+    __m512d c = _mm512_mask_blend_pd(
+            _mm512_cmp_pd_mask(u, _mm512_set1_pd(2), _CMP_GE_OQ),
+            c_small, c_big);
+    c = _mm512_div_pd(c, u);
+    __m512i bits = _mm512_add_epi64(_mm512_castpd_si512(u),
+            _mm512_set1_epi64(kOneBits - kSqrtHalfBits));
+    __m512d exponent = _mm512_castsi512_pd(_mm512_or_si512(
+                _mm512_srli_epi64(bits, 52), _mm512_set1_epi64(kTwo52Bits)));
+    __m512d k = _mm512_sub_pd(_mm512_sub_pd(exponent, _mm512_set1_pd(kTwo52)),
+            _mm512_set1_pd(1023));
+    __m512d m = _mm512_castsi512_pd(_mm512_add_epi64(
+                _mm512_and_si512(bits, _mm512_set1_epi64(kMantissaMask)),
+                _mm512_set1_epi64(kSqrtHalfBits)));
+    __m512d f = _mm512_sub_pd(m, one);
+    __m512d hfsq = _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), f), f);
+    __m512d s = _mm512_div_pd(f, _mm512_add_pd(_mm512_set1_pd(2), f));
+    __m512d z = _mm512_mul_pd(s, s);
+    __m512d r = _mm512_set1_pd(kLg7);
+    const double lg[] = {kLg6, kLg5, kLg4, kLg3, kLg2, kLg1};
+    for (double coefficient : lg) {
+        r = _mm512_add_pd(_mm512_set1_pd(coefficient), _mm512_mul_pd(z, r));
+    }
+    r = _mm512_mul_pd(z, r);
+    __m512d inner = _mm512_add_pd(_mm512_mul_pd(s, _mm512_add_pd(hfsq, r)),
+            _mm512_add_pd(_mm512_mul_pd(k, _mm512_set1_pd(kLn2Lo)), c));
+    return _mm512_sub_pd(_mm512_mul_pd(k, _mm512_set1_pd(kLn2Hi)),
+            _mm512_sub_pd(_mm512_sub_pd(hfsq, inner), f));
+}
+
+__attribute__((target("avx512f")))
+inline void log1p_avx512(const double* in, double* out, size_t n) {
+    const __m512d minus_one = _mm512_set1_pd(-1);
+    const __m512d inf = _mm512_set1_pd(HUGE_VAL);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d x = _mm512_loadu_pd(in + i);
+        __mmask8 special = _mm512_cmp_pd_mask(x, minus_one, _CMP_NGT_UQ) |
+            _mm512_cmp_pd_mask(x, inf, _CMP_EQ_OQ);
+        if (special) {
+            log1p_scalar(in + i, out + i, 8);
+        } else {
+            _mm512_storeu_pd(out + i, log1p_body_avx512(x));
+        }
+    }
+    log1p_scalar(in + i, out + i, n - i);
+}
+#endif
+}
+
+/**
+ * Clamp to [lower, upper]. NaN stays NaN. in and out may be the same array.
+ */
+inline void clip(const double* in, double* out, size_t n,
+        double lower, double upper) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+        return detail::clip_avx512(in, out, n, lower, upper);
+    case Level::AVX2:
+        return detail::clip_avx2(in, out, n, lower, upper);
+    case Level::SSE4:
+        return detail::clip_sse4(in, out, n, lower, upper);
+    default:
+        break;
+    }
+#endif
+    detail::clip_scalar(in, out, n, lower, upper);
+}
+
+inline void clip(const float* in, float* out, size_t n,
+        float lower, float upper) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+        return detail::clip_avx512(in, out, n, lower, upper);
+    case Level::AVX2:
+        return detail::clip_avx2(in, out, n, lower, upper);
+    case Level::SSE4:
+        return detail::clip_sse4(in, out, n, lower, upper);
+    default:
+        break;
+    }
+#endif
+    detail::clip_scalar(in, out, n, lower, upper);
+}
+
+/**
+ * log(1 + x), within 1 ulp of std::log1p, and the same on every level.
+ */
+inline double log1p(double x) {
+    return detail::log1p_scalar(x);
+}
+
+/**
+ * log(1 + x) of every element. in and out may be the same array.
+ */
+inline void log1p(const double* in, double* out, size_t n) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+        return detail::log1p_avx512(in, out, n);
+    case Level::AVX2:
+        return detail::log1p_avx2(in, out, n);
+    case Level::SSE4:
+        return detail::log1p_sse4(in, out, n);
+    default:
+        break;
+    }
+#endif
+    detail::log1p_scalar(in, out, n);
+}
+
+/**
+ * log(1 + x) of a float, computed in double and rounded to float.
+ */
+inline float log1p(float x) {
+    return static_cast<float>(detail::log1p_scalar(x));
+}
+
+/**
+ * Floats go through the double kernel, a block widened at a time, which
+ * costs the conversions but keeps a single polynomial to maintain.
+ */
+inline void log1p(const float* in, float* out, size_t n) {
+    const size_t kBlockSize = 256;
+    double block[kBlockSize];
+    for (size_t i = 0; i < n; i += kBlockSize) {
+        size_t size = std::min(n - i, kBlockSize);
+        std::copy(in + i, in + i + size, block);
+        log1p(block, block, size);
+        for (size_t k = 0; k < size; k++) {
+            out[i + k] = static_cast<float>(block[k]);
+        }
+    }
+}
+
+namespace detail {
+
+inline size_t find_byte_scalar(const char* data, size_t n, const char* set,
+        size_t set_size, bool in_set) {
+    for (size_t i = 0; i < n; i++) {
+        if ((std::memchr(set, data[i], set_size) != nullptr) == in_set) {
+            return i;
+        }
+    }
+    return n;
+}
+
+#if FASTFEA_SIMD_X86
+// Compare 16 (32) bytes against every byte of the set at once; the lowest
+// set bit of the mask is the first match.
+__attribute__((target("sse4.1")))
+inline size_t find_byte_sse4(const char* data, size_t n, const char* set,
+        size_t set_size, bool in_set) {
+    unsigned flip = in_set ? 0 : 0xffff;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i bytes = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(data + i));
+        __m128i match = _mm_setzero_si128();
+        for (size_t j = 0; j < set_size; j++) {
+            match = _mm_or_si128(match,
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8(set[j])));
+        }
+        unsigned mask = (_mm_movemask_epi8(match) ^ flip) & 0xffff;
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + find_byte_scalar(data + i, n - i, set, set_size, in_set);
+}
+
+__attribute__((target("avx2")))
+inline size_t find_byte_avx2(const char* data, size_t n, const char* set,
+        size_t set_size, bool in_set) {
+    uint32_t flip = in_set ? 0 : 0xffffffffu;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(data + i));
+        __m256i match = _mm256_setzero_si256();
+        for (size_t j = 0; j < set_size; j++) {
+            match = _mm256_or_si256(match,
+                    _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(set[j])));
+        }
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(match)) ^
+            flip;
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + find_byte_scalar(data + i, n - i, set, set_size, in_set);
+}
+#endif
+
+inline size_t find_byte(const char* data, size_t n, const char* set,
+        size_t set_size, bool in_set) {
+#if FASTFEA_SIMD_X86
+    // Byte compares on 512 bits need AVX-512BW, which the AVX512 level
+    // doesn't imply; AVX2 does the job there.
+    switch (level()) {
+    case Level::AVX512:
+    case Level::AVX2:
+        return find_byte_avx2(data, n, set, set_size, in_set);
+    case Level::SSE4:
+        return find_byte_sse4(data, n, set, set_size, in_set);
+    default:
+        break;
+    }
+#endif
+    return find_byte_scalar(data, n, set, set_size, in_set);
+}
+}
+
+namespace detail {
+
+inline size_t count_byte_scalar(const char* data, size_t n, char byte) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += data[i] == byte;
+    }
+    return count;
+}
+
+#if FASTFEA_SIMD_X86
+__attribute__((target("sse4.1")))
+inline size_t count_byte_sse4(const char* data, size_t n, char byte) {
+    __m128i b = _mm_set1_epi8(byte);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i bytes = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(data + i));
+        count += __builtin_popcount(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, b)));
+    }
+    return count + count_byte_scalar(data + i, n - i, byte);
+}
+
+__attribute__((target("avx2")))
+inline size_t count_byte_avx2(const char* data, size_t n, char byte) {
+    __m256i b = _mm256_set1_epi8(byte);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(data + i));
+        count += __builtin_popcount(static_cast<uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, b))));
+    }
+    return count + count_byte_scalar(data + i, n - i, byte);
+}
+#endif
+}
+
+/**
+ * Number of bytes of data[0, n) equal to byte.
+ */
+inline size_t count_byte(const char* data, size_t n, char byte) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+    case Level::AVX2:
+        return detail::count_byte_avx2(data, n, byte);
+    case Level::SSE4:
+        return detail::count_byte_sse4(data, n, byte);
+    default:
+        break;
+    }
+#endif
+    return detail::count_byte_scalar(data, n, byte);
+}
+
+/**
+ * Position of the first byte of data[0, n) that is one of set[0, set_size),
+ * or n if there's none. Meant for small sets, e.g. delimiters.
+ */
+inline size_t find_first_of(const char* data, size_t n, const char* set,
+        size_t set_size) {
+    return detail::find_byte(data, n, set, set_size, true);
+}
+
+/**
+ * Position of the first byte of data[0, n) that isn't one of
+ * set[0, set_size), or n if there's none.
+ */
+inline size_t find_first_not_of(const char* data, size_t n, const char* set,
+        size_t set_size) {
+    return detail::find_byte(data, n, set, set_size, false);
+}
+
+namespace detail {
+
+inline void axpy_scalar(const double* x, double* y, size_t n, double a) {
+    for (size_t i = 0; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+#if FASTFEA_SIMD_X86
+__attribute__((target("sse4.1")))
+inline void axpy_sse4(const double* x, double* y, size_t n, double a) {
+    __m128d s = _mm_set1_pd(a);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d product = _mm_mul_pd(_mm_loadu_pd(x + i), s);
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), product));
+    }
+    axpy_scalar(x + i, y + i, n - i, a);
+}
+
+__attribute__((target("avx2")))
+inline void axpy_avx2(const double* x, double* y, size_t n, double a) {
+    __m256d s = _mm256_set1_pd(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d product = _mm256_mul_pd(_mm256_loadu_pd(x + i), s);
+        _mm256_storeu_pd(y + i,
+                _mm256_add_pd(_mm256_loadu_pd(y + i), product));
+    }
+    axpy_scalar(x + i, y + i, n - i, a);
+}
+
+__attribute__((target("avx512f")))
+inline void axpy_avx512(const double* x, double* y, size_t n, double a) {
+    __m512d s = _mm512_set1_pd(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d product = _mm512_mul_pd(_mm512_loadu_pd(x + i), s);
+        _mm512_storeu_pd(y + i,
+                _mm512_add_pd(_mm512_loadu_pd(y + i), product));
+    }
+    axpy_scalar(x + i, y + i, n - i, a);
+}
+#endif
+}
+
+/**
+ * y[i] += a * x[i].
+ */
+inline void axpy(const double* x, double* y, size_t n, double a) {
+#if FASTFEA_SIMD_X86
+    switch (level()) {
+    case Level::AVX512:
+        return detail::axpy_avx512(x, y, n, a);
+    case Level::AVX2:
+        return detail::axpy_avx2(x, y, n, a);
+    case Level::SSE4:
+        return detail::axpy_sse4(x, y, n, a);
+    default:
+        break;
+    }
+#endif
+    detail::axpy_scalar(x, y, n, a);
+}
+} // namespace: simd
+} // namespace: transformer
+
+#endif
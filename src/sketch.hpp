@@ -0,0 +1,286 @@
+/**
+ * Fixed-memory, mergeable summaries of a stream of values, for transformers
+ * whose exact statistics would take memory proportional to the data.
+ */
+#ifndef FASTFEA_SKETCH_H
+#define FASTFEA_SKETCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "hasher.hpp"
+
+namespace transformer {
+
+/**
+ * KLL quantile sketch (Karnin, Lang, Liberty 2016).
+ *
+ * Items live in levels, an item of level h standing for 2^h of the values
+ * pushed. When a level is over its capacity it is compacted: sorted, and
+ * every other item (odd or even ones, at random) is promoted to the next
+ * level. Capacities shrink geometrically (by 2/3) going down from the top
+ * level, so the whole sketch holds O(k) items whatever the stream length, and
+ * the rank error is about 1.7 / k.
+ *
+ * Two sketches merge by concatenating their levels and compacting again, so
+ * threads can each sketch a part of the data.
+ */
+class KllSketch {
+public:
+    explicit KllSketch(size_t k = 200, uint64_t seed = 1) :
+            _k(std::max<size_t>(k, 8)), _random(seed ? seed : 1),
+            _levels(1) {
+        update_capacities();
+    }
+
+    void push(double value) {
+        if (std::isnan(value)) {
+            return;
+        }
+        if (_count == 0 || value < _min) {
+            _min = value;
+        }
+        if (_count == 0 || value > _max) {
+            _max = value;
+        }
+        _levels[0].push_back(value);
+        _count++;
+        _size++;
+        if (_size > _total_capacity) {
+            compress();
+        }
+    }
+
+    void merge(const KllSketch& other) {
+        if (other._count == 0) {
+            return;
+        }
+        if (_count == 0 || other._min < _min) {
+            _min = other._min;
+        }
+        if (_count == 0 || other._max > _max) {
+            _max = other._max;
+        }
+        if (other._levels.size() > _levels.size()) {
+            _levels.resize(other._levels.size());
+            update_capacities();
+        }
+        for (size_t h = 0; h < other._levels.size(); h++) {
+            _levels[h].insert(_levels[h].end(), other._levels[h].begin(),
+                    other._levels[h].end());
+        }
+        _count += other._count;
+        _size += other._size;
+        compress();
+    }
+
+    uint64_t count() const {
+        return _count;
+    }
+
+    /**
+     * Number of items held, which bounds the memory used.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * Approximate values at each of the given ranks (ascending, in [0, 1]).
+     * Ranks 0 and 1 give the exact minimum and maximum. Empty sketch gives
+     * all zeros.
+     */
+    std::vector<double> quantiles(const std::vector<double>& ranks) const {
+        std::vector<std::pair<double, uint64_t>> items;
+        for (size_t h = 0; h < _levels.size(); h++) {
+            for (double value : _levels[h]) {
+                items.emplace_back(value, uint64_t(1) << h);
+            }
+        }
+        std::sort(items.begin(), items.end());
+        std::vector<double> output;
+        uint64_t total = 0;
+        for (const auto& item : items) {
+            total += item.second;
+        }
+        uint64_t weight = 0;
+        size_t i = 0;
+        for (double rank : ranks) {
+            if (items.empty()) {
+                output.push_back(0);
+                continue;
+            }
+            if (rank <= 0 || rank >= 1) {
+                output.push_back(rank <= 0 ? _min : _max);
+                continue;
+            }
+            double target = rank * total;
+            while (i + 1 < items.size() && weight + items[i].second < target) {
+                weight += items[i].second;
+                i++;
+            }
+            output.push_back(items[i].first);
+        }
+        return output;
+    }
+
+    double quantile(double rank) const {
+        return quantiles({rank})[0];
+    }
+
+private:
+    void update_capacities() {
+        _capacities.resize(_levels.size());
+        _total_capacity = 0;
+        for (size_t h = 0; h < _levels.size(); h++) {
+            size_t depth = _levels.size() - 1 - h;
+            _capacities[h] = std::max<size_t>(2, static_cast<size_t>(
+                        std::ceil(_k * std::pow(2.0 / 3.0, depth))));
+            _total_capacity += _capacities[h];
+        }
+    }
+
+    /**
+     * Compact the lowest full level until the sketch is within capacity.
+     */
+    void compress() {
+        while (_size > _total_capacity) {
+            for (size_t h = 0; h < _levels.size(); h++) {
+                if (_levels[h].size() >= _capacities[h]) {
+                    compact(h);
+                    break;
+                }
+            }
+        }
+    }
+
+    void compact(size_t h) {
+        if (h + 1 == _levels.size()) {
+            _levels.emplace_back();
+            update_capacities();
+        }
+        std::vector<double>& level = _levels[h];
+        std::sort(level.begin(), level.end());
+        // An odd item out stays behind, the rest is halved.
+        double leftover = 0;
+        bool has_leftover = level.size() % 2 == 1;
+        if (has_leftover) {
+            leftover = level.back();
+            level.pop_back();
+        }
+        std::vector<double>& next = _levels[h + 1];
+        for (size_t i = next_bit(); i < level.size(); i += 2) {
+            next.push_back(level[i]);
+        }
+        _size -= level.size() / 2;
+        level.clear();
+        if (has_leftover) {
+            level.push_back(leftover);
+        }
+    }
+
+    // xorshift64, we only need a fair, reproducible coin.
+    size_t next_bit() {
+        _random ^= _random << 13;
+        _random ^= _random >> 7;
+        _random ^= _random << 17;
+        return _random >> 63;
+    }
+
+    size_t _k;
+    uint64_t _random;
+    uint64_t _count = 0;
+    size_t _size = 0;
+    double _min = 0;
+    double _max = 0;
+    std::vector<std::vector<double>> _levels;
+    std::vector<size_t> _capacities;
+    size_t _total_capacity = 0;
+};
+
+/**
+ * How transformers that count keys (TfIdf, CountEncoder) count them:
+ * exactly, in memory growing with the number of distinct keys, or in a
+ * CountMinSketch of fixed size.
+ */
+enum class Counting {
+    Exact,
+    Sketch,
+};
+
+/**
+ * Count-min sketch (Cormode, Muthukrishnan 2005): approximate counts of
+ * keys (64-bit hashes) in fixed memory.
+ *
+ * depth rows of width counters; a key adds to one counter per row, picked
+ * by a hash of its own per row. A count is the smallest of the key's
+ * counters: never below the true count, and above it by at most
+ * e / width * (total count) with probability 1 - exp(-depth).
+ *
+ * Sketches of the same shape and seed merge by adding counters.
+ */
+class CountMinSketch {
+public:
+    /**
+     * Memory is width * depth counters; width is rounded up to a power of
+     * two.
+     */
+    explicit CountMinSketch(size_t width = 1 << 16, size_t depth = 4,
+            uint64_t seed = 1) : _width(1), _depth(std::max<size_t>(depth, 1)),
+            _seed(seed) {
+        while (_width < width) {
+            _width *= 2;
+        }
+        _counters.assign(_width * _depth, 0);
+    }
+
+    void add(uint64_t key, uint64_t count = 1) {
+        for (size_t row = 0; row < _depth; row++) {
+            _counters[cell(row, key)] += count;
+        }
+    }
+
+    uint64_t count(uint64_t key) const {
+        uint64_t count = _counters[cell(0, key)];
+        for (size_t row = 1; row < _depth; row++) {
+            count = std::min(count, _counters[cell(row, key)]);
+        }
+        return count;
+    }
+
+    void merge(const CountMinSketch& other) {
+        if (other._width != _width || other._depth != _depth ||
+                other._seed != _seed) {
+            throw std::invalid_argument(
+                    "CountMinSketch: merging sketches of different shapes");
+        }
+        for (size_t i = 0; i < _counters.size(); i++) {
+            _counters[i] += other._counters[i];
+        }
+    }
+
+    size_t width() const {
+        return _width;
+    }
+
+    size_t depth() const {
+        return _depth;
+    }
+
+private:
+    size_t cell(size_t row, uint64_t key) const {
+        return row * _width + (mix_hash(_seed + row, key) & (_width - 1));
+    }
+
+    size_t _width;
+    size_t _depth;
+    uint64_t _seed;
+    std::vector<uint64_t> _counters;
+};
+} // namespace: transformer
+
+#endif
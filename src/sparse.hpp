@@ -0,0 +1,96 @@
+/**
+ * Sparse feature vector, for outputs with a few non-zeros among many
+ * dimensions (one-hot codes, hashed features, bags of words).
+ */
+#ifndef FASTFEA_SPARSE_H
+#define FASTFEA_SPARSE_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace transformer {
+
+/**
+ * Non-zero entries of a vector of dimension dim: values[i] is at
+ * indices[i]. Indices are kept in ascending order, with no duplicates.
+ */
+template<typename T>
+struct SparseVector {
+    size_t dim = 0;
+    std::vector<uint32_t> indices;
+    std::vector<T> values;
+
+    SparseVector() {}
+    explicit SparseVector(size_t dim) : dim(dim) {}
+
+    /**
+     * Append an entry, index must be above those already there.
+     */
+    void push_back(uint32_t index, T value) {
+        indices.push_back(index);
+        values.push_back(value);
+    }
+
+    size_t nnz() const {
+        return indices.size();
+    }
+
+    std::vector<T> to_dense() const {
+        std::vector<T> dense(dim);
+        for (size_t i = 0; i < indices.size(); i++) {
+            dense[indices[i]] = values[i];
+        }
+        return dense;
+    }
+
+    bool operator==(const SparseVector& other) const {
+        return dim == other.dim && indices == other.indices &&
+            values == other.values;
+    }
+
+    bool operator!=(const SparseVector& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * Like std::vector, two sparse vectors combine into one, the second one's
+ * dimensions following the first one's.
+ */
+template<typename T>
+SparseVector<T> combine(SparseVector<T>&& first_out,
+        SparseVector<T>&& second_out) {
+    SparseVector<T> out(std::move(first_out));
+    uint32_t offset = static_cast<uint32_t>(out.dim);
+    out.dim += second_out.dim;
+    out.indices.reserve(out.indices.size() + second_out.indices.size());
+    for (uint32_t index : second_out.indices) {
+        out.indices.push_back(index + offset);
+    }
+    out.values.insert(out.values.end(), second_out.values.begin(),
+            second_out.values.end());
+    return out;
+}
+/**
+ * Call func(index, value) on the non-zeros of a dense or sparse vector, in
+ * index order.
+ */
+template<typename T, typename Func>
+void for_each_nonzero(const std::vector<T>& vector, Func func) {
+    for (size_t i = 0; i < vector.size(); i++) {
+        if (vector[i] != 0) {
+            func(i, vector[i]);
+        }
+    }
+}
+
+template<typename T, typename Func>
+void for_each_nonzero(const SparseVector<T>& vector, Func func) {
+    for (size_t i = 0; i < vector.nnz(); i++) {
+        func(vector.indices[i], vector.values[i]);
+    }
+}
+} // namespace: transformer
+
+#endif
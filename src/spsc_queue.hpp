@@ -0,0 +1,119 @@
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer
+ * thread.
+ */
+#ifndef FASTFEA_SPSC_QUEUE_H
+#define FASTFEA_SPSC_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace transformer {
+
+/**
+ * Ring buffer of capacity (rounded up to a power of two) slots. The producer
+ * only writes _tail and the consumer only writes _head, each on its own cache
+ * line, so the two sides don't contend unless the queue is full or empty.
+ *
+ * push blocks while the queue is full, which is what gives backpressure to
+ * the producer. The producer calls close() after its last push, and pop
+ * returns false once everything pushed before that was popped.
+ *
+ * A queue may be given a cancel flag, shared with other queues. Once it is
+ * set, push and pop give up and return false right away.
+ */
+template<typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity,
+            std::shared_ptr<std::atomic<bool>> cancelled = nullptr) :
+            _cancelled(std::move(cancelled)) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _slots.resize(size);
+        _mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool try_push(T&& value) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) > _mask) {
+            return false;
+        }
+        _slots[tail & _mask] = std::move(value);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(_slots[head & _mask]);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Return false if the queue got cancelled before value went in.
+     */
+    bool push(T&& value) {
+        while (!try_push(std::move(value))) {
+            if (is_cancelled()) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    /**
+     * Return false when the queue is closed and drained, or cancelled.
+     */
+    bool pop(T& value) {
+        while (!try_pop(value)) {
+            if (is_cancelled()) {
+                return false;
+            }
+            if (_closed.load(std::memory_order_acquire)) {
+                // Last pushes may have landed between try_pop and the check.
+                return try_pop(value);
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    void close() {
+        _closed.store(true, std::memory_order_release);
+    }
+
+    size_t capacity() const {
+        return _slots.size();
+    }
+
+private:
+    bool is_cancelled() const {
+        return _cancelled && _cancelled->load(std::memory_order_relaxed);
+    }
+
+    std::vector<T> _slots;
+    size_t _mask;
+    std::shared_ptr<std::atomic<bool>> _cancelled;
+    std::atomic<bool> _closed{false};
+    char _head_pad[64];
+    std::atomic<size_t> _head{0};
+    char _tail_pad[64];
+    std::atomic<size_t> _tail{0};
+    char _end_pad[64];
+};
+} // namespace: transformer
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ * Standardizer: scale a numeric feature to zero mean and unit variance,
+ * (x - mean) / std, with the mean and (population) standard deviation across
+ * all samples.
+ */
+#ifndef FASTFEA_STANDARDIZER_H
+#define FASTFEA_STANDARDIZER_H
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "elementwise.hpp"
+#include "simd.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+/**
+ * Running count, mean and sum of squared deviations (Welford's algorithm).
+ *
+ * Unlike accumulating sum and sum of squares, it doesn't lose all precision
+ * when the variance is small compared to the mean. Two Moments over disjoint
+ * samples merge exactly (Chan et al.), so shards may be fitted in parallel.
+ */
+struct Moments {
+    uint64_t count = 0;
+    double mean = 0;
+    double m2 = 0;
+
+    void push(double x) {
+        count++;
+        double delta = x - mean;
+        mean += delta / count;
+        m2 += delta * (x - mean);
+    }
+
+    void merge(const Moments& other) {
+        if (other.count == 0) {
+            return;
+        }
+        if (count == 0) {
+            *this = other;
+            return;
+        }
+        uint64_t total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * count / total * other.count;
+        count = total;
+    }
+
+    double variance() const {
+        return count == 0 ? 0 : m2 / count;
+    }
+};
+
+/**
+ * Standardize a scalar feature, From being double or float (e.g.
+ * Standardizer<FeatureValue>).
+ *
+ * A constant feature has no spread, it is only centered (to 0).
+ */
+template<typename From>
+class Standardizer : public ElementwiseTransformer<From> {
+public:
+    Standardizer() { this->_is_finalized = false; }
+
+    virtual void step(const From& sample) {
+        _moments.push(sample);
+    }
+
+    /**
+     * Fold in the state of a Standardizer fitted on other samples.
+     */
+    void merge(const Standardizer& other) {
+        _moments.merge(other._moments);
+    }
+
+    virtual void finalize() {
+        double stddev = std::sqrt(_moments.variance());
+        double scale = stddev > 0 ? 1 / stddev : 1;
+        _scale = static_cast<From>(scale);
+        _shift = static_cast<From>(-_moments.mean * scale);
+        this->_is_finalized = true;
+    }
+
+    /**
+     * Further samples update the moments, as if fitted from the start.
+     */
+    virtual void extend() {
+        this->_is_finalized = false;
+    }
+
+    virtual From transform(const From& sample) const {
+        return sample * _scale + _shift;
+    }
+
+    virtual void apply(From* data, size_t n) const {
+        simd::affine(data, data, n, _scale, _shift);
+    }
+
+    virtual bool affine(From* scale, From* shift) const {
+        *scale = _scale;
+        *shift = _shift;
+        return true;
+    }
+
+    const Moments& moments() const {
+        return _moments;
+    }
+
+    virtual std::shared_ptr<Transformer<From, From>> clone() const {
+        return std::make_shared<Standardizer>(*this);
+    }
+
+private:
+    Moments _moments;
+    From _scale = 1;
+    From _shift = 0;
+};
+
+/**
+ * Standardize every dimension of a vector feature on its own. All samples
+ * must have the same size. T, the element type of samples and output, is
+ * double or float; moments are accumulated in double either way.
+ */
+template<typename T>
+class Standardizer<std::vector<T>> :
+        public Transformer<std::vector<T>, std::vector<T>> {
+    static_assert(std::is_same<T, double>::value ||
+            std::is_same<T, float>::value,
+            "Standardizer: vectors of double or float");
+
+public:
+    Standardizer() { this->_is_finalized = false; }
+
+    virtual void step(const std::vector<T>& sample) {
+        if (_moments.empty()) {
+            _moments.resize(sample.size());
+        }
+        check_size(sample, _moments.size());
+        for (size_t i = 0; i < sample.size(); i++) {
+            _moments[i].push(sample[i]);
+        }
+    }
+
+    void merge(const Standardizer& other) {
+        if (_moments.empty()) {
+            _moments.resize(other._moments.size());
+        }
+        if (!other._moments.empty() &&
+                other._moments.size() != _moments.size()) {
+            throw std::invalid_argument("Standardizer: dimensions differ");
+        }
+        for (size_t i = 0; i < other._moments.size(); i++) {
+            _moments[i].merge(other._moments[i]);
+        }
+    }
+
+    virtual void finalize() {
+        _scale.resize(_moments.size());
+        _shift.resize(_moments.size());
+        for (size_t i = 0; i < _moments.size(); i++) {
+            double stddev = std::sqrt(_moments[i].variance());
+            double scale = stddev > 0 ? 1 / stddev : 1;
+            _scale[i] = static_cast<T>(scale);
+            _shift[i] = static_cast<T>(-_moments[i].mean * scale);
+        }
+        this->_is_finalized = true;
+    }
+
+    virtual void extend() {
+        this->_is_finalized = false;
+    }
+
+    virtual std::vector<T> transform(const std::vector<T>& sample) const {
+        check_size(sample, _scale.size());
+        std::vector<T> output(sample.size());
+        simd::affine_columns(sample.data(), output.data(), sample.size(),
+                _scale.data(), _shift.data());
+        return output;
+    }
+
+    virtual std::vector<T> transform(std::vector<T>&& sample) {
+        check_size(sample, _scale.size());
+        simd::affine_columns(sample.data(), sample.data(), sample.size(),
+                _scale.data(), _shift.data());
+        return std::move(sample);
+    }
+
+    using Transformer<std::vector<T>, std::vector<T>>::transform_batch;
+
+    virtual std::vector<std::vector<T>> transform_batch(
+            std::vector<std::vector<T>>&& samples) {
+        for (std::vector<T>& sample : samples) {
+            check_size(sample, _scale.size());
+            simd::affine_columns(sample.data(), sample.data(), sample.size(),
+                    _scale.data(), _shift.data());
+        }
+        return std::move(samples);
+    }
+
+    virtual size_t output_dim() const {
+        return _moments.size();
+    }
+
+    const std::vector<Moments>& moments() const {
+        return _moments;
+    }
+
+    virtual std::shared_ptr<Transformer<std::vector<T>, std::vector<T>>>
+    clone() const {
+        return std::make_shared<Standardizer>(*this);
+    }
+
+private:
+    static void check_size(const std::vector<T>& sample, size_t size) {
+        if (sample.size() != size) {
+            throw std::invalid_argument("Standardizer: dimensions differ");
+        }
+    }
+
+    std::vector<Moments> _moments;
+    std::vector<T> _scale;
+    std::vector<T> _shift;
+};
+} // namespace: transformer
+
+#endif
@@ -0,0 +1,201 @@
+/**
+ * Streaming execution of a chain of transformers, one thread per stage.
+ *
+ * `a + b + c + d` transforms every batch on the calling thread, stage after
+ * stage. A Stream instead puts each stage on its own thread, connected by
+ * bounded SpscQueue of batches, so stages work on different batches at the
+ * same time, and also overlap with reading the input and consuming the
+ * output. A full queue blocks the stage feeding it (backpressure), so a slow
+ * stage never makes memory grow.
+ *
+ * A stage is any transformer, so several cheap stages can be grouped on one
+ * thread simply by joining them with + first:
+ *
+ *     make_stream(a + b).then(c).then(d).run(source, sink);
+ *
+ * Stages must be finalized already, Stream only calls transform_batch.
+ */
+#ifndef FASTFEA_STREAM_H
+#define FASTFEA_STREAM_H
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+namespace stream_detail {
+
+/**
+ * Shared by every thread of one Stream::run.
+ */
+struct RunState {
+    explicit RunState(size_t capacity) :
+            cancelled(std::make_shared<std::atomic<bool>>(false)),
+            queue_capacity(capacity) {}
+
+    /**
+     * Keep the first error, and make every other thread give up.
+     */
+    void fail(std::exception_ptr exception) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = exception;
+            }
+        }
+        cancelled->store(true);
+    }
+
+    template<typename T>
+    std::shared_ptr<SpscQueue<std::vector<T>>> make_queue() {
+        return std::make_shared<SpscQueue<std::vector<T>>>(
+                queue_capacity, cancelled);
+    }
+
+    std::shared_ptr<std::atomic<bool>> cancelled;
+    size_t queue_capacity;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::exception_ptr error;
+};
+}
+
+template<typename From, typename To>
+class Stream {
+    template<typename, typename> friend class Stream;
+
+    template<typename T>
+    using QueuePtr = std::shared_ptr<SpscQueue<std::vector<T>>>;
+    // Start the threads of all stages reading from the given queue, return
+    // the queue the last stage writes to.
+    using Connect = std::function<QueuePtr<To>(QueuePtr<From>,
+            stream_detail::RunState&)>;
+
+public:
+    /**
+     * queue_capacity is the number of batches that may wait between two
+     * stages.
+     */
+    explicit Stream(std::shared_ptr<Transformer<From, To>> stage,
+            size_t queue_capacity = 8) : _queue_capacity(queue_capacity) {
+        _connect = [stage](QueuePtr<From> input,
+                stream_detail::RunState& state) -> QueuePtr<To> {
+            return start_stage(stage, input, state);
+        };
+    }
+
+    /**
+     * Append a stage running on a thread of its own.
+     */
+    template<typename Next>
+    Stream<From, Next> then(std::shared_ptr<Transformer<To, Next>> stage) const {
+        Connect connect = _connect;
+        typename Stream<From, Next>::Connect next_connect = [connect, stage](
+                QueuePtr<From> input, stream_detail::RunState& state) {
+            return start_stage(stage, connect(input, state), state);
+        };
+        return Stream<From, Next>(std::move(next_connect), _queue_capacity);
+    }
+
+    /**
+     * Run the whole stream to completion.
+     *
+     * source is called (on a thread of its own) to fill the next batch of
+     * input, and returns false when there is no more input; the batch passed
+     * to it is empty. sink is called on the calling thread with each output
+     * batch, in input order.
+     *
+     * An exception thrown by any stage, source or sink stops the stream and
+     * is rethrown here.
+     */
+    void run(std::function<bool(std::vector<From>&)> source,
+            std::function<void(std::vector<To>&&)> sink) const {
+        stream_detail::RunState state(_queue_capacity);
+        auto input = state.make_queue<From>();
+        QueuePtr<To> output;
+        try {
+            output = _connect(input, state);
+            state.threads.emplace_back([&state, input, source]() {
+                try {
+                    while (true) {
+                        std::vector<From> batch;
+                        if (!source(batch)) {
+                            break;
+                        }
+                        if (batch.empty()) {
+                            continue;
+                        }
+                        if (!input->push(std::move(batch))) {
+                            break;
+                        }
+                    }
+                } catch (...) {
+                    state.fail(std::current_exception());
+                }
+                input->close();
+            });
+            std::vector<To> batch;
+            while (output->pop(batch)) {
+                sink(std::move(batch));
+            }
+        } catch (...) {
+            state.fail(std::current_exception());
+        }
+        for (auto& thread : state.threads) {
+            thread.join();
+        }
+        if (state.error) {
+            std::rethrow_exception(state.error);
+        }
+    }
+
+private:
+    Stream(Connect connect, size_t queue_capacity) :
+            _connect(std::move(connect)), _queue_capacity(queue_capacity) {}
+
+    template<typename In, typename Out>
+    static QueuePtr<Out> start_stage(
+            std::shared_ptr<Transformer<In, Out>> stage,
+            QueuePtr<In> input, stream_detail::RunState& state) {
+        auto output = state.template make_queue<Out>();
+        stream_detail::RunState* state_ptr = &state;
+        state.threads.emplace_back([stage, input, output, state_ptr]() {
+            try {
+                std::vector<In> batch;
+                while (input->pop(batch)) {
+                    // Nothing reads the batch after this stage, which may
+                    // transform it in place.
+                    if (!output->push(stage->transform_batch(
+                                    std::move(batch)))) {
+                        break;
+                    }
+                    batch.clear();
+                }
+            } catch (...) {
+                state_ptr->fail(std::current_exception());
+            }
+            output->close();
+        });
+        return output;
+    }
+
+    Connect _connect;
+    size_t _queue_capacity;
+};
+
+template<typename From, typename To>
+Stream<From, To> make_stream(std::shared_ptr<Transformer<From, To>> stage,
+        size_t queue_capacity = 8) {
+    return Stream<From, To>(std::move(stage), queue_capacity);
+}
+} // namespace: transformer
+
+#endif
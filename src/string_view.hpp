@@ -0,0 +1,108 @@
+/**
+ * StringView: a non-owning reference to characters held elsewhere, like
+ * C++17's std::string_view, which C++11 doesn't have.
+ *
+ * Text transformers hand out views into their input rather than copies, so
+ * splitting a document doesn't allocate a string per token. A view is only
+ * valid as long as the characters it points to.
+ */
+#ifndef FASTFEA_STRING_VIEW_H
+#define FASTFEA_STRING_VIEW_H
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+
+#include "hasher.hpp"
+
+namespace transformer {
+
+class StringView {
+public:
+    StringView() : _data(nullptr), _size(0) {}
+    StringView(const char* data, size_t size) : _data(data), _size(size) {}
+    StringView(const char* data) : _data(data), _size(std::strlen(data)) {}
+    StringView(const std::string& str) :
+            _data(str.data()), _size(str.size()) {}
+
+    const char* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    const char* begin() const {
+        return _data;
+    }
+
+    const char* end() const {
+        return _data + _size;
+    }
+
+    char operator[](size_t i) const {
+        return _data[i];
+    }
+
+    StringView substr(size_t pos, size_t count) const {
+        pos = std::min(pos, _size);
+        return StringView(_data + pos, std::min(count, _size - pos));
+    }
+
+    /**
+     * An owning copy.
+     */
+    std::string str() const {
+        return std::string(_data, _size);
+    }
+
+    bool operator==(const StringView& other) const {
+        return _size == other._size &&
+            (_size == 0 || std::memcmp(_data, other._data, _size) == 0);
+    }
+
+    bool operator!=(const StringView& other) const {
+        return !(*this == other);
+    }
+
+    bool operator<(const StringView& other) const {
+        size_t n = std::min(_size, other._size);
+        int order = n == 0 ? 0 : std::memcmp(_data, other._data, n);
+        return order < 0 || (order == 0 && _size < other._size);
+    }
+
+private:
+    const char* _data;
+    size_t _size;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const StringView& view) {
+    return out.write(view.data(), view.size());
+}
+
+// Hashes as the std::string with the same bytes.
+template<>
+struct HashAppend<StringView> {
+    static void apply(HashState* state, const StringView& view) {
+        state->update_bytes(view.data(), view.size());
+    }
+};
+} // namespace: transformer
+
+namespace std {
+    template<>
+    struct hash<transformer::StringView> {
+        size_t operator()(const transformer::StringView& view) const {
+            return transformer::hash_bytes(view.data(), view.size());
+        }
+    };
+}
+
+#endif
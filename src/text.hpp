@@ -0,0 +1,316 @@
+/**
+ * Transformers for text columns, which work on StringViews into the text
+ * and on hashes rather than on strings: no string is allocated per token.
+ *
+ *   (std::string --Lowercase--> std::string)
+ *   text (StringView) --Tokenizer--> tokens (std::vector<StringView>)
+ *     --NGram--> n-gram hashes (std::vector<uint64_t>)
+ *     --FeatureHasher--> bag of n-grams (SparseVector<double>)
+ *     or --MultiHotBinarizer--> learned vocabulary (std::vector or BitVector)
+ *
+ * Tokens point into the text, so the text must outlive them. Within a
+ * pipeline it does when the first stage returns a view into the sample,
+ * e.g. a lazy transformer returning StringView(sample.text): tokens are used
+ * up before transform returns. Hashes own nothing and can be kept.
+ */
+#ifndef FASTFEA_TEXT_H
+#define FASTFEA_TEXT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.hpp"
+#include "hasher.hpp"
+#include "simd.hpp"
+#include "sparse.hpp"
+#include "string_view.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+/**
+ * Split text on delimiter bytes, by default ASCII whitespace. Empty tokens
+ * (runs of delimiters) are skipped. Delimiters are found with the SIMD byte
+ * scan of simd.hpp, a few delimiters is cheapest.
+ */
+class Tokenizer : public Transformer<StringView, std::vector<StringView>> {
+public:
+    explicit Tokenizer(const std::string& delimiters = " \t\n\r\f\v") :
+            _delimiters(delimiters) {}
+
+    virtual std::vector<StringView> transform(const StringView& text) const {
+        std::vector<StringView> tokens;
+        tokenize(text, &tokens);
+        return tokens;
+    }
+
+    /**
+     * Append the tokens of text to tokens, e.g. to reuse its storage from
+     * one document to the next.
+     */
+    void tokenize(const StringView& text,
+            std::vector<StringView>* tokens) const {
+        const char* data = text.data();
+        size_t n = text.size();
+        size_t i = 0;
+        while (i < n) {
+            i += simd::find_first_not_of(data + i, n - i,
+                    _delimiters.data(), _delimiters.size());
+            if (i == n) {
+                break;
+            }
+            size_t length = simd::find_first_of(data + i, n - i,
+                    _delimiters.data(), _delimiters.size());
+            tokens->push_back(StringView(data + i, length));
+            i += length;
+        }
+    }
+
+    virtual std::shared_ptr<BaseType> clone() const {
+        return std::make_shared<Tokenizer>(*this);
+    }
+
+private:
+    std::string _delimiters;
+};
+
+/**
+ * ASCII lower case, e.g. before tokenizing or binarizing. A string the
+ * caller is done with is lowered in place.
+ */
+class Lowercase : public Transformer<std::string, std::string> {
+public:
+    virtual std::string transform(const std::string& text) const {
+        std::string output(text);
+        lower(&output);
+        return output;
+    }
+
+    virtual std::string transform(std::string&& text) {
+        lower(&text);
+        return std::move(text);
+    }
+
+    using Transformer<std::string, std::string>::transform_batch;
+
+    virtual std::vector<std::string> transform_batch(
+            std::vector<std::string>&& texts) {
+        for (std::string& text : texts) {
+            lower(&text);
+        }
+        return std::move(texts);
+    }
+
+    virtual std::shared_ptr<BaseType> clone() const {
+        return std::make_shared<Lowercase>(*this);
+    }
+
+private:
+    static void lower(std::string* text) {
+        for (char& c : *text) {
+            if (c >= 'A' && c <= 'Z') {
+                c += 'a' - 'A';
+            }
+        }
+    }
+};
+
+template<typename From>
+class NGram;
+
+/**
+ * Hashes of the word n-grams of a token sequence, for every n in
+ * [min_n, max_n]: all the n-grams starting at the first token, then at the
+ * second, etc. Equal n-grams hash equally whatever the text they come
+ * from.
+ */
+template<>
+class NGram<std::vector<StringView>> :
+        public Transformer<std::vector<StringView>, std::vector<uint64_t>> {
+public:
+    explicit NGram(size_t min_n = 1, size_t max_n = 2, uint64_t seed = 0) :
+            _min_n(min_n), _max_n(max_n), _seed(seed) {
+        if (min_n == 0 || min_n > max_n) {
+            throw std::invalid_argument("NGram: need 0 < min_n <= max_n");
+        }
+    }
+
+    virtual std::vector<uint64_t> transform(
+            const std::vector<StringView>& tokens) const {
+        ArenaScope scope;
+        ArenaVector<uint64_t> token_hashes = scope.vector<uint64_t>();
+        token_hashes.reserve(tokens.size());
+        for (const StringView& token : tokens) {
+            token_hashes.push_back(hash_bytes(token.data(), token.size()));
+        }
+        std::vector<uint64_t> output;
+        output.reserve(tokens.size() * (_max_n - _min_n + 1));
+        for (size_t start = 0; start < tokens.size(); start++) {
+            uint64_t h = _seed;
+            size_t end = std::min(tokens.size(), start + _max_n);
+            for (size_t i = start; i < end; i++) {
+                h = mix_hash(h, token_hashes[i]);
+                if (i - start + 1 >= _min_n) {
+                    output.push_back(h);
+                }
+            }
+        }
+        return output;
+    }
+
+    virtual std::shared_ptr<BaseType> clone() const {
+        return std::make_shared<NGram>(*this);
+    }
+
+private:
+    size_t _min_n;
+    size_t _max_n;
+    uint64_t _seed;
+};
+
+/**
+ * Hashes of the character (byte) n-grams of a text, for every n in
+ * [min_n, max_n], in the same order as word n-grams.
+ */
+template<>
+class NGram<StringView> :
+        public Transformer<StringView, std::vector<uint64_t>> {
+public:
+    explicit NGram(size_t min_n = 3, size_t max_n = 3, uint64_t seed = 0) :
+            _min_n(min_n), _max_n(max_n), _seed(seed) {
+        if (min_n == 0 || min_n > max_n) {
+            throw std::invalid_argument("NGram: need 0 < min_n <= max_n");
+        }
+    }
+
+    virtual std::vector<uint64_t> transform(const StringView& text) const {
+        std::vector<uint64_t> output;
+        for (size_t start = 0; start + _min_n <= text.size(); start++) {
+            size_t longest = std::min(_max_n, text.size() - start);
+            for (size_t n = _min_n; n <= longest; n++) {
+                output.push_back(hash_bytes(text.data() + start, n, _seed));
+            }
+        }
+        return output;
+    }
+
+    virtual std::shared_ptr<BaseType> clone() const {
+        return std::make_shared<NGram>(*this);
+    }
+
+private:
+    size_t _min_n;
+    size_t _max_n;
+    uint64_t _seed;
+};
+
+/**
+ * The hashing trick: a bag of hashes becomes counts in a fixed number of
+ * buckets, with nothing to learn and no vocabulary to keep.
+ */
+class FeatureHasher :
+        public Transformer<std::vector<uint64_t>, SparseVector<double>> {
+public:
+    explicit FeatureHasher(size_t num_buckets = 1 << 20) :
+            _num_buckets(num_buckets) {
+        if (num_buckets == 0 || num_buckets > UINT32_MAX) {
+            throw std::invalid_argument("FeatureHasher: bad num_buckets");
+        }
+    }
+
+    virtual SparseVector<double> transform(
+            const std::vector<uint64_t>& hashes) const {
+        ArenaScope scope;
+        ArenaVector<uint32_t> buckets = scope.vector<uint32_t>();
+        buckets.reserve(hashes.size());
+        for (uint64_t h : hashes) {
+            buckets.push_back(static_cast<uint32_t>(h % _num_buckets));
+        }
+        std::sort(buckets.begin(), buckets.end());
+        SparseVector<double> output(_num_buckets);
+        for (size_t i = 0; i < buckets.size(); i++) {
+            if (output.nnz() > 0 && output.indices.back() == buckets[i]) {
+                output.values.back() += 1;
+            } else {
+                output.push_back(buckets[i], 1);
+            }
+        }
+        return output;
+    }
+
+    virtual size_t output_dim() const {
+        return _num_buckets;
+    }
+
+    size_t num_buckets() const {
+        return _num_buckets;
+    }
+
+    virtual std::shared_ptr<BaseType> clone() const {
+        return std::make_shared<FeatureHasher>(*this);
+    }
+
+private:
+    size_t _num_buckets;
+};
+
+/**
+ * Binarizer for bags of levels (e.g. n-gram hashes): step learns every
+ * level of the bag, and the output has a 1 for each level present. Levels
+ * unseen when fitting are ignored rather than rejected, new words being
+ * the norm in text.
+ */
+template<typename T, typename Value = FeatureValue,
+        template<typename> class Hash = FastHash>
+class MultiHotBinarizer : public Transformer<std::vector<T>,
+        typename BinaryVector<Value>::type> {
+    typedef typename BinaryVector<Value>::type Output;
+
+public:
+    MultiHotBinarizer() { this->_is_finalized = false; }
+
+    virtual void step(const std::vector<T>& sample) {
+        for (const T& level : sample) {
+            if (_data_to_val.find(level) == _data_to_val.end()) {
+                _data_to_val[level] = _count++;
+            }
+        }
+    }
+
+    /**
+     * As Binarizer: new levels are numbered after the existing ones.
+     */
+    virtual void extend() {
+        this->_is_finalized = false;
+    }
+
+    virtual Output transform(const std::vector<T>& sample) const {
+        Output output(_count);
+        for (const T& level : sample) {
+            auto it = _data_to_val.find(level);
+            if (it != _data_to_val.end()) {
+                BinaryVector<Value>::set(&output, it->second);
+            }
+        }
+        return output;
+    }
+
+    virtual size_t output_dim() const {
+        return _count;
+    }
+
+    virtual std::shared_ptr<Transformer<std::vector<T>, Output>> clone() const {
+        return std::make_shared<MultiHotBinarizer>(*this);
+    }
+
+protected:
+    int _count = 0;
+    std::unordered_map<T, int, Hash<T>> _data_to_val;
+};
+} // namespace: transformer
+
+#endif
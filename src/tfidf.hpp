@@ -0,0 +1,191 @@
+/**
+ * TfIdf: term frequency times inverse document frequency weighting of bags
+ * of terms, e.g. n-gram hashes from text.hpp.
+ *
+ * step counts, for every term, the documents it appears in, either exactly
+ * in a FlatHashMap, or in a CountMinSketch when there are too many distinct
+ * terms to keep (memory is then fixed, and rare terms may look a bit more
+ * common than they are). finalize freezes the IDF of every term,
+ *   idf = log((1 + documents) / (1 + documents with the term)) + 1
+ * (smoothed as if one more document had every term, so unseen terms get a
+ * finite weight).
+ *
+ * transform hashes the terms of a document into a SparseVector of
+ * num_buckets dimensions, like FeatureHasher, each term weighing its count
+ * in the document times its IDF, and scales it to unit L2 norm.
+ */
+#ifndef FASTFEA_TFIDF_H
+#define FASTFEA_TFIDF_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "flat_map.hpp"
+#include "sketch.hpp"
+#include "sparse.hpp"
+#include "transformer.hpp"
+
+namespace transformer {
+
+class TfIdf :
+        public Transformer<std::vector<uint64_t>, SparseVector<double>> {
+public:
+    /**
+     * sketch_width and sketch_depth size the CountMinSketch of Sketch
+     * counting, and are ignored otherwise.
+     */
+    explicit TfIdf(size_t num_buckets = 1 << 20,
+            Counting counting = Counting::Exact,
+            size_t sketch_width = 1 << 20, size_t sketch_depth = 4) :
+            _num_buckets(num_buckets), _counting(counting),
+            _sketch(counting == Counting::Sketch ? sketch_width : 1,
+                    counting == Counting::Sketch ? sketch_depth : 1) {
+        if (num_buckets == 0 || num_buckets > UINT32_MAX) {
+            throw std::invalid_argument("TfIdf: bad num_buckets");
+        }
+        this->_is_finalized = false;
+    }
+
+    virtual void step(const std::vector<uint64_t>& terms) {
+        ArenaScope scope;
+        ArenaVector<uint64_t> unique = scope.vector<uint64_t>();
+        unique.assign(terms.begin(), terms.end());
+        std::sort(unique.begin(), unique.end());
+        unique.erase(std::unique(unique.begin(), unique.end()),
+                unique.end());
+        for (uint64_t term : unique) {
+            if (_counting == Counting::Exact) {
+                _exact[term]++;
+            } else {
+                _sketch.add(term);
+            }
+        }
+        _num_docs++;
+    }
+
+    /**
+     * Fold in the document frequencies of a TfIdf fitted on other
+     * documents, with the same counting (and sketch size).
+     */
+    void merge(const TfIdf& other) {
+        if (other._counting != _counting) {
+            throw std::invalid_argument("TfIdf: merging different countings");
+        }
+        if (_counting == Counting::Exact) {
+            other._exact.for_each([this](uint64_t term, uint64_t count) {
+                _exact[term] += count;
+            });
+        } else {
+            _sketch.merge(other._sketch);
+        }
+        _num_docs += other._num_docs;
+    }
+
+    virtual void finalize() {
+        _unseen_idf = idf(0);
+        if (_counting == Counting::Exact) {
+            _exact_idf.clear();
+            _exact_idf.reserve(_exact.size());
+            _exact.for_each([this](uint64_t term, uint64_t count) {
+                _exact_idf[term] = idf(count);
+            });
+        }
+        this->_is_finalized = true;
+    }
+
+    /**
+     * Further documents add to the frequencies, the next finalize
+     * recomputes every IDF.
+     */
+    virtual void extend() {
+        this->_is_finalized = false;
+    }
+
+    virtual SparseVector<double> transform(
+            const std::vector<uint64_t>& terms) const {
+        ArenaScope scope;
+        ArenaVector<uint64_t> sorted = scope.vector<uint64_t>();
+        sorted.assign(terms.begin(), terms.end());
+        std::sort(sorted.begin(), sorted.end());
+        auto weights = scope.vector<std::pair<uint32_t, double>>();
+        weights.reserve(sorted.size());
+        for (size_t i = 0; i < sorted.size();) {
+            size_t j = i + 1;
+            while (j < sorted.size() && sorted[j] == sorted[i]) {
+                j++;
+            }
+            weights.emplace_back(
+                    static_cast<uint32_t>(sorted[i] % _num_buckets),
+                    (j - i) * term_idf(sorted[i]));
+            i = j;
+        }
+        std::sort(weights.begin(), weights.end());
+        SparseVector<double> output(_num_buckets);
+        for (const auto& weight : weights) {
+            if (output.nnz() > 0 && output.indices.back() == weight.first) {
+                output.values.back() += weight.second;
+            } else {
+                output.push_back(weight.first, weight.second);
+            }
+        }
+        double norm = 0;
+        for (double value : output.values) {
+            norm += value * value;
+        }
+        if (norm > 0) {
+            double scale = 1 / std::sqrt(norm);
+            for (double& value : output.values) {
+                value *= scale;
+            }
+        }
+        return output;
+    }
+
+    /**
+     * IDF of a term. With exact counting, as frozen by finalize; a sketch
+     * is read as is, so between extend and finalize its IDFs already count
+     * the new documents.
+     */
+    double term_idf(uint64_t term) const {
+        if (_counting == Counting::Exact) {
+            const double* idf = _exact_idf.find(term);
+            return idf ? *idf : _unseen_idf;
+        }
+        // The sketch's estimate is its smallest counter: no table of IDFs
+        // next to the counters, it would double their memory.
+        return idf(_sketch.count(term));
+    }
+
+    virtual size_t output_dim() const {
+        return _num_buckets;
+    }
+
+    uint64_t num_docs() const {
+        return _num_docs;
+    }
+
+    virtual std::shared_ptr<BaseType> clone() const {
+        return std::make_shared<TfIdf>(*this);
+    }
+
+private:
+    double idf(uint64_t count) const {
+        return std::log((1.0 + _num_docs) / (1.0 + count)) + 1;
+    }
+
+    size_t _num_buckets;
+    Counting _counting;
+    uint64_t _num_docs = 0;
+    FlatHashMap<uint64_t, uint64_t> _exact;
+    CountMinSketch _sketch;
+    FlatHashMap<uint64_t, double> _exact_idf;
+    double _unseen_idf = 1;
+};
+} // namespace: transformer
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * A small fixed-size thread pool used to run independent transformers
+ * concurrently.
+ */
+#ifndef FASTFEA_THREAD_POOL_H
+#define FASTFEA_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace transformer {
+
+/**
+ * A unit of work submitted to a ThreadPool.
+ *
+ * Whoever calls run() first executes the work, either a worker or the thread
+ * waiting for it. So a task that blocks on a nested task which is still
+ * queued simply runs it inline, and the pool can't deadlock on itself.
+ */
+class Task {
+public:
+    explicit Task(std::function<void()> func) : _func(std::move(func)) {}
+
+    void run() {
+        if (_claimed.exchange(true)) {
+            return;
+        }
+        try {
+            _func();
+        } catch (...) {
+            _error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done = true;
+        }
+        _cond.notify_all();
+    }
+
+    /**
+     * Run the task here if no worker picked it up yet, otherwise block until
+     * it's done. Exception thrown by the task is rethrown to the waiter.
+     */
+    void wait() {
+        run();
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cond.wait(lock, [this]() { return _done; });
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+    }
+
+private:
+    std::function<void()> _func;
+    std::atomic<bool> _claimed{false};
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    bool _done = false;
+    std::exception_ptr _error;
+};
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads =
+            std::thread::hardware_concurrency()) {
+        num_threads = std::max<size_t>(num_threads, 1);
+        for (size_t i = 0; i < num_threads; i++) {
+            _workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopped = true;
+        }
+        _cond.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::shared_ptr<Task> submit(std::function<void()> func) {
+        auto task = std::make_shared<Task>(std::move(func));
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queue.push_back(task);
+        }
+        _cond.notify_one();
+        return task;
+    }
+
+    size_t size() const {
+        return _workers.size();
+    }
+
+private:
+    void work() {
+        while (true) {
+            std::shared_ptr<Task> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cond.wait(lock, [this]() {
+                    return _stopped || !_queue.empty();
+                });
+                if (_queue.empty()) {
+                    return;
+                }
+                task = std::move(_queue.front());
+                _queue.pop_front();
+            }
+            task->run();
+        }
+    }
+
+    std::vector<std::thread> _workers;
+    std::deque<std::shared_ptr<Task>> _queue;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    bool _stopped = false;
+};
+
+/**
+ * Wait for every task, rethrowing the first exception only after all of
+ * them are done (tasks usually capture the caller's locals by reference).
+ */
+inline void wait_all(const std::vector<std::shared_ptr<Task>>& tasks) {
+    std::exception_ptr error;
+    for (const auto& task : tasks) {
+        try {
+            task->wait();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+} // namespace: transformer
+
+#endif
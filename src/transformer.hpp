@@ -22,11 +22,27 @@
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
 
+#include "bit_vector.hpp"
 #include "hasher.hpp"
 
+/**
+ * Element type of the numeric vectors transformers output when not told
+ * otherwise. double by default; build with -DFASTFEA_VALUE_TYPE=float to
+ * halve the memory (and bandwidth) of feature vectors, which models rarely
+ * need in double precision.
+ */
+#ifndef FASTFEA_VALUE_TYPE
+#define FASTFEA_VALUE_TYPE double
+#endif
+
 namespace transformer {
 
+typedef FASTFEA_VALUE_TYPE FeatureValue;
+
 template<class From, class To>
 using TransformFunc = std::function<To(const From& sampl)>;
 
@@ -34,6 +50,8 @@ template<typename From, typename To>
 class Transformer {
 public:
     using BaseType = Transformer<From, To>;
+    using FromType = From;
+    using ToType = To;
 
     virtual ~Transformer() {}
     /**
@@ -47,20 +65,101 @@ public:
     virtual void step(From&& sample) {
         step(sample);
     }
+    /**
+     * Step through a batch of samples, in order. Equivalent to calling step
+     * on each of them.
+     */
+    virtual void step_batch(const std::vector<From>& samples) {
+        for (const auto& sample : samples) {
+            step(sample);
+        }
+    }
     /**
      * After finishing all samples, this function will be called.
      */
     virtual void finalize() {};
     /**
-     * Transform new data, return a vector of string.
-     * Here we use double because it's general, and fastfea is not responsible
-     * for training, but rather output a numeric feature set for other modeling
-     * to train.
+     * Reopen a finalized transformer to learn from new samples on top of what
+     * it has learned so far: step through the new samples, then finalize
+     * again. It costs only as much as the new samples.
+     *
+     * Transformers that don't learn, or can't learn incrementally, stay
+     * frozen.
+     */
+    virtual void extend() {}
+    /**
+     * Transform new data. Numeric outputs are FeatureValue (double unless
+     * configured) by default, or the element type the transformer was given
+     * (e.g. Binarizer<From, float>, or uint8_t for one-hot codes): fastfea is
+     * not responsible for training, but rather output a numeric feature set
+     * for other modeling to train.
      */
     virtual To transform(const From& sample) const = 0;
+    /**
+     * Transform a sample the caller is done with. Transformers whose output
+     * is their input modified (e.g. normalising a string, scaling a vector)
+     * override it to do so in place rather than on a copy.
+     */
     virtual To transform(From&& sample) {
         return transform(sample);
     }
+    /**
+     * Transform a batch of samples. Equivalent to calling transform on each
+     * of them.
+     */
+    virtual std::vector<To> transform_batch(
+            const std::vector<From>& samples) const {
+        return transform_batch(samples.data(), samples.size());
+    }
+    /**
+     * Transform the batch [first, first + n), e.g. a slice of a larger
+     * array, without copying it into a vector. Transformers that can
+     * process a batch faster as a whole override this one, the vector
+     * overload above comes here.
+     */
+    virtual std::vector<To> transform_batch(const From* first,
+            size_t n) const {
+        std::vector<To> output;
+        output.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            output.emplace_back(transform(first[i]));
+        }
+        return output;
+    }
+    /**
+     * Transform a batch the caller is done with, in place where possible.
+     */
+    virtual std::vector<To> transform_batch(std::vector<From>&& samples) {
+        return transform_batch(static_cast<const std::vector<From>&>(
+                    samples));
+    }
+    /**
+     * Number of dimensions of the output, 1 for a scalar, 0 when not known
+     * (e.g. for a lazy transformer). Fitted transformers only know it once
+     * finalized.
+     */
+    virtual size_t output_dim() const {
+        return 0;
+    }
+    /**
+     * Return a transformer doing the work of this one followed by next, in
+     * a single pass (e.g. one loop over a batch for element-wise numeric
+     * transformers, see elementwise.hpp), or null when there's no such
+     * thing, which is the default. Only meaningful once both are finalized.
+     */
+    virtual std::shared_ptr<Transformer<From, To>> fuse(
+            const std::shared_ptr<Transformer<To, To>>& next) const {
+        return nullptr;
+    }
+    /**
+     * An independent copy of this transformer, learned state included:
+     * stepping or finalizing one leaves the other alone. Composites clone
+     * their stages. Transformers that can't be copied throw logic_error,
+     * which is the default.
+     */
+    virtual std::shared_ptr<Transformer<From, To>> clone() const {
+        throw std::logic_error("Transformer: clone is not supported");
+    }
     bool is_finalized() const {
         return _is_finalized;
     }
@@ -72,9 +171,16 @@ protected:
 /**
  * 1-of-K coding
  * e.g. 0001, 0010, 0100, 1000 for 4-level categorical variable.
+ *
+ * Value is the element type of the output; bool packs it in a BitVector.
+ * Hash is the hash policy of the vocabulary, FastHash or std::hash.
  */
-template<typename From>
-class Binarizer : public Transformer<From, std::vector<double>> {
+template<typename From, typename Value = FeatureValue,
+        template<typename> class Hash = FastHash>
+class Binarizer :
+        public Transformer<From, typename BinaryVector<Value>::type> {
+    typedef typename BinaryVector<Value>::type Output;
+
 public:
     Binarizer() { this->_is_finalized = false; }
     virtual void step(const From& sample) {
@@ -83,24 +189,49 @@ public:
         }
     }
 
-    virtual std::vector<double> transform(const From& sample) const {
+    /**
+     * New levels are numbered after the existing ones, so an existing level
+     * keeps its position in the output.
+     */
+    virtual void extend() {
+        this->_is_finalized = false;
+    }
+
+    virtual Output transform(const From& sample) const {
         int val = _data_to_val.at(sample);
-        std::vector<double> output;
-        for (int i = 0; i < _count; i++) {
-            if (val == i) {
-                output.emplace_back(1.0);
-            } else {
-                output.emplace_back(0.0);
-            }
-        }
+        Output output(_count);
+        BinaryVector<Value>::set(&output, val);
         return output;
     }
 
-private:
+    virtual size_t output_dim() const {
+        return _count;
+    }
+
+    virtual std::shared_ptr<Transformer<From, Output>> clone() const {
+        return std::make_shared<Binarizer>(*this);
+    }
+
+protected:
     int _count = 0;
-    std::unordered_map<From, int> _data_to_val;
+    std::unordered_map<From, int, Hash<From>> _data_to_val;
 };
 
+template<typename From, typename Middle, typename To>
+std::shared_ptr<Transformer<From, To>> fuse_stages(
+        const std::shared_ptr<Transformer<From, Middle>>& first,
+        const std::shared_ptr<Transformer<Middle, To>>& second) {
+    return nullptr;
+}
+
+// Only stages from a type to itself may fuse with what comes before them.
+template<typename From, typename To>
+std::shared_ptr<Transformer<From, To>> fuse_stages(
+        const std::shared_ptr<Transformer<From, To>>& first,
+        const std::shared_ptr<Transformer<To, To>>& second) {
+    return first->fuse(second);
+}
+
 template<typename From, typename Middle, typename To>
 class Pipeline : public Transformer<From, To> {
 public:
@@ -109,11 +240,24 @@ public:
             _first(first), _second(second) {
         if (_first->is_finalized() && _second->is_finalized()) {
             this->_is_finalized = true;
+            _fused = fuse_stages(_first, _second);
         } else {
             this->_is_finalized = false;
         }
     }
 
+    /**
+     * Copies clone the stages, see clone.
+     */
+    Pipeline(const Pipeline& other) : Transformer<From, To>(other),
+            _first(other._first->clone()), _second(other._second->clone()),
+            _data(other._data) {
+        if (this->is_finalized()) {
+            _fused = fuse_stages(_first, _second);
+        }
+    }
+    Pipeline(Pipeline&&) = default;
+
     virtual void step(const From& sample) {
         if (this->is_finalized()) {
             return;
@@ -132,28 +276,120 @@ public:
         }
     }
 
+    /**
+     * The sample is moved to the buffer, or into _first when it's fitted.
+     */
+    virtual void step(From&& sample) {
+        if (this->is_finalized()) {
+            return;
+        }
+
+        if (_first->is_finalized()) {
+            if (!_second->is_finalized()) {
+                _second->step(_first->transform(std::move(sample)));
+            }
+        }
+        else {
+            _first->step(sample);
+            if (!_second->is_finalized()) {
+                _data.emplace(std::move(sample));
+            }
+        }
+    }
+
     virtual void finalize() {
         if (!_first->is_finalized()) {
             _first->finalize();
         }
         if (!_second->is_finalized()) {
             while (!_data.empty()) {
-                _second->step(_first->transform(_data.front()));
+                _second->step(_first->transform(std::move(_data.front())));
                 _data.pop();
             }
             _second->finalize();
         }
         this->_is_finalized = true;
+        _fused = fuse_stages(_first, _second);
+    }
+
+    virtual void extend() {
+        _fused = nullptr;
+        _first->extend();
+        _second->extend();
+        this->_is_finalized = _first->is_finalized() &&
+            _second->is_finalized();
     }
 
+    /**
+     * _first's output is a temporary, _second gets it as an rvalue.
+     */
     virtual To transform(const From& sample) const {
+        if (_fused) {
+            return _fused->transform(sample);
+        }
         return _second->transform(_first->transform(sample));
     }
 
+    virtual To transform(From&& sample) {
+        if (_fused) {
+            return _fused->transform(std::move(sample));
+        }
+        return _second->transform(_first->transform(std::move(sample)));
+    }
+
+    using Transformer<From, To>::transform_batch;
+
+    virtual std::vector<To> transform_batch(const From* first,
+            size_t n) const {
+        if (_fused) {
+            return _fused->transform_batch(first, n);
+        }
+        return _second->transform_batch(_first->transform_batch(first, n));
+    }
+
+    virtual std::vector<To> transform_batch(std::vector<From>&& samples) {
+        if (_fused) {
+            return _fused->transform_batch(std::move(samples));
+        }
+        return _second->transform_batch(
+                _first->transform_batch(std::move(samples)));
+    }
+
+    virtual size_t output_dim() const {
+        return _second->output_dim();
+    }
+
+    /**
+     * Fusing a + b + c with d: the pipelines are built left to right, so
+     * the stage d should fuse with is the last one, c, or whatever c was
+     * already fused into.
+     */
+    virtual std::shared_ptr<Transformer<From, To>> fuse(
+            const std::shared_ptr<Transformer<To, To>>& next) const {
+        if (!this->is_finalized()) {
+            return nullptr;
+        }
+        if (_fused) {
+            return _fused->fuse(next);
+        }
+        auto tail = _second->fuse(next);
+        if (!tail) {
+            return nullptr;
+        }
+        return std::make_shared<Pipeline<From, Middle, To>>(_first, tail);
+    }
+
+    virtual std::shared_ptr<Transformer<From, To>> clone() const {
+        return std::make_shared<Pipeline>(*this);
+    }
+
 private:
     std::shared_ptr<Transformer<From, Middle>> _first;
     std::shared_ptr<Transformer<Middle, To>> _second;
     std::queue<From> _data;
+    // Equivalent of _first followed by _second, computed in fewer passes,
+    // once both are fitted.
+    std::shared_ptr<Transformer<From, To>> _fused;
 };
 
 
@@ -192,6 +428,20 @@ std::vector<T> combine(std::vector<T>&& first_out,
     return out;
 }
 
+/**
+ * Vectors of different numeric types (e.g. a uint8_t one-hot code and
+ * float values) combine as their common type.
+ */
+template<typename T1, typename T2>
+std::vector<typename std::common_type<T1, T2>::type> combine(
+        std::vector<T1>&& first_out, std::vector<T2>&& second_out) {
+    std::vector<typename std::common_type<T1, T2>::type> out;
+    out.reserve(first_out.size() + second_out.size());
+    out.insert(out.end(), first_out.begin(), first_out.end());
+    out.insert(out.end(), second_out.begin(), second_out.end());
+    return out;
+}
+
 // Combiner, by itself, just call two transformer in sequence with the same
 // input.
 // It's useless as standalone, but can combine with pipeline to provide
@@ -210,6 +460,13 @@ public:
         this->_is_finalized = false;
     }
 
+    /**
+     * Copies clone the branches, see clone.
+     */
+    Combiner(const Combiner& other) : TransformerCombineT(other),
+            _first(other._first->clone()), _second(other._second->clone()) {}
+    Combiner(Combiner&&) = default;
+
     virtual void step(const From& sample) {
         if (!_first->is_finalized()) {
             _first->step(sample);
@@ -219,6 +476,17 @@ public:
         }
     }
 
+    // Only the second transformer may have the sample, the first one has
+    // to see it intact.
+    virtual void step(From&& sample) {
+        if (!_first->is_finalized()) {
+            _first->step(sample);
+        }
+        if (!_second->is_finalized()) {
+            _second->step(std::move(sample));
+        }
+    }
+
     virtual void finalize() {
         if (!_first->is_finalized()) {
             _first->finalize();
@@ -229,12 +497,65 @@ public:
         this->_is_finalized = true;
     }
 
+    virtual void extend() {
+        _first->extend();
+        _second->extend();
+        this->_is_finalized = _first->is_finalized() &&
+            _second->is_finalized();
+    }
+
     virtual CombineT transform(const From& sample) const {
         return combine(_first->transform(sample),
             _second->transform(sample));
     }
 
-private:
+    virtual CombineT transform(From&& sample) {
+        To1 first_out = _first->transform(sample);
+        return combine(std::move(first_out),
+                _second->transform(std::move(sample)));
+    }
+
+    using TransformerCombineT::transform_batch;
+
+    virtual std::vector<CombineT> transform_batch(const From* first,
+            size_t n) const {
+        auto first_out = _first->transform_batch(first, n);
+        auto second_out = _second->transform_batch(first, n);
+        return combine_batch(std::move(first_out), std::move(second_out));
+    }
+
+    virtual std::vector<CombineT> transform_batch(
+            std::vector<From>&& samples) {
+        auto first_out = _first->transform_batch(samples);
+        auto second_out = _second->transform_batch(std::move(samples));
+        return combine_batch(std::move(first_out), std::move(second_out));
+    }
+
+    /**
+     * Dimensions of the two outputs, concatenated.
+     */
+    virtual size_t output_dim() const {
+        size_t first = _first->output_dim();
+        size_t second = _second->output_dim();
+        return first && second ? first + second : 0;
+    }
+
+    virtual std::shared_ptr<TransformerCombineT> clone() const {
+        return std::make_shared<Combiner>(*this);
+    }
+
+protected:
+    static std::vector<CombineT> combine_batch(std::vector<To1>&& first_out,
+            std::vector<To2>&& second_out) {
+        std::vector<CombineT> output;
+        output.reserve(first_out.size());
+        for (size_t i = 0; i < first_out.size(); i++) {
+            output.emplace_back(combine(std::move(first_out[i]),
+                        std::move(second_out[i])));
+        }
+        return output;
+    }
+
     std::shared_ptr<Transformer1T> _first;
     std::shared_ptr<Transformer2T> _second;
 };
@@ -274,6 +595,10 @@ public:
     virtual To transform(const From& sample) const {
         return _func(sample);
     }
+
+    virtual std::shared_ptr<Transformer<From, To>> clone() const {
+        return std::make_shared<LazyTransformer>(*this);
+    }
 private:
     std::function<To(const From& sample)> _func;
 };
@@ -0,0 +1,439 @@
+/**
+ * Writers of transformed batches (dense std::vector, Segments, SparseVector
+ * or BitVector rows)
+ * in formats downstream learners read directly:
+ * - LibSvmWriter: LibSVM / svmlight text, "label index:value ...", with
+ *   the shortest decimal that reads back as the same value (float or
+ *   double, as in the row),
+ * - CsrWriter: a binary CSR matrix (indptr, indices, values arrays).
+ *
+ * Output goes through a BufferedWriter: one large write per full buffer,
+ * from a page-aligned buffer, instead of a stream call per value.
+ */
+#ifndef FASTFEA_WRITER_H
+#define FASTFEA_WRITER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bit_vector.hpp"
+#include "segments.hpp"
+#include "sparse.hpp"
+
+namespace transformer {
+
+/**
+ * Append-only file output through a large aligned buffer.
+ */
+class BufferedWriter {
+public:
+    explicit BufferedWriter(const std::string& path,
+            size_t buffer_size = 1 << 20) :
+            _path(path), _capacity(buffer_size) {
+        _fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (_fd < 0) {
+            throw std::runtime_error("BufferedWriter: can't open " + path +
+                    ": " + std::strerror(errno));
+        }
+        void* buffer = nullptr;
+        if (::posix_memalign(&buffer, kAlignment, _capacity) != 0) {
+            ::close(_fd);
+            throw std::bad_alloc();
+        }
+        _buffer = static_cast<char*>(buffer);
+    }
+
+    /**
+     * Flushes and closes, ignoring errors: call close() to see them.
+     */
+    ~BufferedWriter() {
+        if (_fd >= 0) {
+            try {
+                close();
+            } catch (...) {
+            }
+        }
+        std::free(_buffer);
+    }
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    void write(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            size_t chunk = std::min(size, _capacity - _size);
+            std::memcpy(_buffer + _size, bytes, chunk);
+            _size += chunk;
+            bytes += chunk;
+            size -= chunk;
+            if (_size == _capacity) {
+                flush();
+            }
+        }
+    }
+
+    /**
+     * Room for size more bytes, to format into in place; commit them
+     * with advance(). size must be at most the buffer size.
+     */
+    char* reserve(size_t size) {
+        if (_capacity - _size < size) {
+            flush();
+        }
+        return _buffer + _size;
+    }
+
+    void advance(size_t size) {
+        _size += size;
+    }
+
+    void flush() {
+        size_t done = 0;
+        while (done < _size) {
+            ssize_t written = ::write(_fd, _buffer + done, _size - done);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("BufferedWriter: can't write " +
+                        _path + ": " + std::strerror(errno));
+            }
+            done += written;
+        }
+        _offset += _size;
+        _size = 0;
+    }
+
+    void close() {
+        flush();
+        int fd = _fd;
+        _fd = -1;
+        if (::close(fd) != 0) {
+            throw std::runtime_error("BufferedWriter: can't close " + _path +
+                    ": " + std::strerror(errno));
+        }
+    }
+
+    /**
+     * Bytes written so far, buffered ones included.
+     */
+    uint64_t offset() const {
+        return _offset + _size;
+    }
+
+    int fd() const {
+        return _fd;
+    }
+
+private:
+    static const size_t kAlignment = 4096;
+
+    std::string _path;
+    int _fd = -1;
+    char* _buffer = nullptr;
+    size_t _capacity;
+    size_t _size = 0;
+    uint64_t _offset = 0;
+};
+
+/**
+ * Write the decimal digits of value into out (at least 20 bytes), return
+ * their count.
+ */
+inline size_t format_unsigned(uint64_t value, char* out) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+namespace writer_detail {
+
+/**
+ * Integers, e.g. one-hot 1s, are formatted directly.
+ */
+inline size_t format_integer(double value, char* out) {
+    size_t sign = std::signbit(value) ? 1 : 0;
+    out[0] = '-';
+    return sign + format_unsigned(static_cast<uint64_t>(std::fabs(value)),
+            out + sign);
+}
+
+/**
+ * %g with the fewest digits from first_precision to last_precision that
+ * read back as value, through parse (strtod or strtof).
+ */
+template<typename T, typename Parse>
+size_t format_round_trip(T value, char* out, int first_precision,
+        int last_precision, Parse parse) {
+    int length = 0;
+    for (int precision = first_precision; precision <= last_precision;
+            precision++) {
+        length = std::snprintf(out, 32, "%.*g", precision,
+                static_cast<double>(value));
+        if (precision == last_precision || parse(out) == value ||
+                std::isnan(value)) {
+            break;
+        }
+    }
+    return static_cast<size_t>(length);
+}
+} // namespace: writer_detail
+
+/**
+ * Write the shortest decimal that parses back to value into out (at least
+ * 32 bytes), return its length.
+ *
+ * A normal double whose shortest decimal has at most 15 significant digits
+ * is exactly its rounding to 15 digits; failing that, 16 or 17 digits are
+ * tried. Subnormals, which have fewer digits of precision, try every
+ * precision from 1.
+ */
+inline size_t format_shortest(double value, char* out) {
+    if (value == std::trunc(value) && std::fabs(value) < 1e15) {
+        return writer_detail::format_integer(value, out);
+    }
+    return writer_detail::format_round_trip(value, out,
+            std::fabs(value) < DBL_MIN ? 1 : 15, 17,
+            [](const char* text) { return std::strtod(text, nullptr); });
+}
+
+/**
+ * The same for a float, e.g. rows of the float build: 6 to 9 digits (from
+ * 1 for subnormals), so that 0.1f is written 0.1 rather than as the double
+ * it widens to.
+ */
+inline size_t format_shortest(float value, char* out) {
+    // Past 7 digits, %g may be shorter than the integer's digits.
+    if (value == std::trunc(value) && std::fabs(value) < 1e7f) {
+        return writer_detail::format_integer(value, out);
+    }
+    return writer_detail::format_round_trip(value, out,
+            std::fabs(value) < FLT_MIN ? 1 : 6, 9,
+            [](const char* text) { return std::strtof(text, nullptr); });
+}
+
+/**
+ * Type in which the values of a Row are formatted: float for rows of
+ * floats, double otherwise (integers, bits).
+ */
+template<typename T>
+struct FormatValue {
+    typedef typename std::conditional<std::is_same<T, float>::value,
+            float, double>::type type;
+};
+
+template<typename Row>
+struct RowFormatValue {
+    typedef double type;
+};
+
+template<typename T>
+struct RowFormatValue<std::vector<T>> : FormatValue<T> {};
+
+template<typename T>
+struct RowFormatValue<SparseVector<T>> : FormatValue<T> {};
+
+template<typename T>
+struct RowFormatValue<Segments<T>> : FormatValue<T> {};
+
+/**
+ * LibSVM text, one line per row: the label, then index:value for every
+ * non-zero, indices counting from first_index (1 for LibSVM, 0 is accepted
+ * by XGBoost and LightGBM).
+ */
+class LibSvmWriter {
+public:
+    explicit LibSvmWriter(const std::string& path, uint32_t first_index = 1) :
+            _out(path), _first_index(first_index) {}
+
+    template<typename Row>
+    void write(const Row& row, double label = 0) {
+        typedef typename RowFormatValue<Row>::type Value;
+        _out.advance(format_shortest(label, _out.reserve(kMaxLabelSize)));
+        for_each_nonzero(row, [this](size_t index, Value value) {
+            char* p = _out.reserve(kMaxEntrySize);
+            char* start = p;
+            *p++ = ' ';
+            p += format_unsigned(index + _first_index, p);
+            *p++ = ':';
+            p += format_shortest(value, p);
+            _out.advance(p - start);
+        });
+        _out.write("\n", 1);
+    }
+
+    /**
+     * labels may be empty (all 0), or have one label per row.
+     */
+    template<typename Row>
+    void write_batch(const std::vector<Row>& rows,
+            const std::vector<double>& labels = std::vector<double>()) {
+        if (!labels.empty() && labels.size() != rows.size()) {
+            throw std::invalid_argument("LibSvmWriter: one label per row");
+        }
+        for (size_t i = 0; i < rows.size(); i++) {
+            write(rows[i], labels.empty() ? 0 : labels[i]);
+        }
+    }
+
+    void close() {
+        _out.close();
+    }
+
+private:
+    static const size_t kMaxLabelSize = 32;
+    static const size_t kMaxEntrySize = 64;
+
+    BufferedWriter _out;
+    uint32_t _first_index;
+};
+
+/**
+ * Binary CSR matrix, little-endian:
+ *
+ *   header  "FFCSR001", then uint64 num_rows, num_cols, nnz, and the
+ *           byte offsets of indptr, indices and values (64 bytes),
+ *   indptr  uint64[num_rows + 1], row i is entries [indptr[i], indptr[i+1]),
+ *   indices uint32[nnz], column of each entry,
+ *   values  float64[nnz].
+ *
+ * e.g. in Python:
+ *   scipy.sparse.csr_matrix((values, indices, indptr), (num_rows, num_cols))
+ *
+ * Indices go to the file as rows come, values to a side file appended at
+ * close(), where indptr (8 bytes per row, kept in memory) and the header
+ * are written. num_cols is the largest row dimension.
+ */
+class CsrWriter {
+public:
+    explicit CsrWriter(const std::string& path) :
+            _path(path), _out(path), _values_path(path + ".values.tmp"),
+            _values(new BufferedWriter(_values_path)), _indptr(1, 0) {
+        std::vector<char> header(kHeaderSize);
+        _out.write(header.data(), header.size());
+    }
+
+    ~CsrWriter() {
+        if (_values) {
+            _values.reset();
+            std::remove(_values_path.c_str());
+        }
+    }
+
+    template<typename Row>
+    void write(const Row& row) {
+        for_each_nonzero(row, [this](size_t index, double value) {
+            uint32_t column = static_cast<uint32_t>(index);
+            _out.write(&column, sizeof(column));
+            _values->write(&value, sizeof(value));
+            _nnz++;
+        });
+        _num_cols = std::max<uint64_t>(_num_cols, dim(row));
+        _indptr.push_back(_nnz);
+    }
+
+    template<typename Row>
+    void write_batch(const std::vector<Row>& rows) {
+        for (const Row& row : rows) {
+            write(row);
+        }
+    }
+
+    /**
+     * Complete the file: nothing is readable before.
+     */
+    void close() {
+        // Values are 8-byte aligned: pad after the uint32 indices.
+        if (_out.offset() % 8) {
+            uint32_t padding = 0;
+            _out.write(&padding, sizeof(padding));
+        }
+        uint64_t values_offset = _out.offset();
+        _values->close();
+        _values.reset();
+        append_file(_values_path);
+        std::remove(_values_path.c_str());
+        uint64_t indptr_offset = _out.offset();
+        _out.write(_indptr.data(), _indptr.size() * sizeof(uint64_t));
+        _out.flush();
+
+        uint64_t header[7] = {0, _indptr.size() - 1, _num_cols, _nnz,
+            indptr_offset, kHeaderSize, values_offset};
+        std::memcpy(header, "FFCSR001", 8);
+        if (::pwrite(_out.fd(), header, sizeof(header), 0) !=
+                static_cast<ssize_t>(sizeof(header))) {
+            throw std::runtime_error("CsrWriter: can't write header of " +
+                    _path);
+        }
+        _out.close();
+    }
+
+private:
+    static const size_t kHeaderSize = 64;
+
+    template<typename T>
+    static uint64_t dim(const std::vector<T>& row) {
+        return row.size();
+    }
+
+    template<typename T>
+    static uint64_t dim(const SparseVector<T>& row) {
+        return row.dim;
+    }
+
+    static uint64_t dim(const BitVector& row) {
+        return row.size();
+    }
+
+    template<typename T>
+    static uint64_t dim(const Segments<T>& row) {
+        return row.size();
+    }
+
+    void append_file(const std::string& path) {
+        std::FILE* in = std::fopen(path.c_str(), "rb");
+        if (!in) {
+            throw std::runtime_error("CsrWriter: can't read " + path);
+        }
+        std::vector<char> buffer(1 << 20);
+        size_t size;
+        while ((size = std::fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+            _out.write(buffer.data(), size);
+        }
+        std::fclose(in);
+    }
+
+    std::string _path;
+    BufferedWriter _out;
+    std::string _values_path;
+    std::unique_ptr<BufferedWriter> _values;
+    std::vector<uint64_t> _indptr;
+    uint64_t _nnz = 0;
+    uint64_t _num_cols = 0;
+};
+} // namespace: transformer
+
+#endif
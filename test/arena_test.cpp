@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "arena.hpp"
+
+using transformer::Arena;
+using transformer::ArenaScope;
+using transformer::ArenaVector;
+using transformer::scratch_arena;
+
+TEST(arena, aligned_bump_allocation) {
+    Arena arena(256);
+    char* a = static_cast<char*>(arena.allocate(3, 1));
+    char* b = static_cast<char*>(arena.allocate(8, 8));
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(b) % 8);
+    EXPECT_GT(b, a);
+    EXPECT_EQ(256u, arena.capacity());
+
+    // Too large for a block: gets a block of its own.
+    arena.allocate(1000, 8);
+    EXPECT_GE(arena.capacity(), 1256u);
+}
+
+TEST(arena, rewind_reuses_memory) {
+    Arena arena(256);
+    arena.allocate(16);
+    Arena::Mark mark = arena.mark();
+    void* first = arena.allocate(100);
+    arena.allocate(200);
+    size_t capacity = arena.capacity();
+
+    arena.rewind(mark);
+    EXPECT_EQ(first, arena.allocate(100));
+    arena.allocate(200);
+    EXPECT_EQ(capacity, arena.capacity());
+
+    arena.reset();
+    arena.allocate(16);
+    EXPECT_EQ(first, arena.allocate(100));
+}
+
+TEST(arena, scopes_nest) {
+    ArenaScope outer;
+    ArenaVector<int> kept = outer.vector<int>();
+    kept.assign({1, 2, 3});
+    void* next;
+    {
+        ArenaScope inner;
+        ArenaVector<int> temporary = inner.vector<int>();
+        temporary.resize(1000, 7);
+        next = temporary.data();
+    }
+    EXPECT_EQ(std::vector<int>({1, 2, 3}),
+            std::vector<int>(kept.begin(), kept.end()));
+    // The inner scope's memory is handed out again.
+    ArenaScope again;
+    EXPECT_EQ(next, again.arena().allocate(4, alignof(int)));
+}
+
+TEST(arena, one_scratch_arena_per_thread) {
+    Arena* main_arena = &scratch_arena();
+    Arena* other_arena = nullptr;
+    std::thread thread([&other_arena]() {
+        other_arena = &scratch_arena();
+    });
+    thread.join();
+    EXPECT_EQ(main_arena, &scratch_arena());
+    EXPECT_NE(main_arena, other_arena);
+}
+
+TEST(arena, shrink_frees_unused_blocks) {
+    Arena arena(256);
+    arena.allocate(100);
+    Arena::Mark mark = arena.mark();
+    arena.allocate(200);
+    arena.allocate(5000);
+    EXPECT_GT(arena.capacity(), 5000u);
+
+    // Blocks in use are kept.
+    arena.shrink(0);
+    EXPECT_GT(arena.capacity(), 5000u);
+    arena.rewind(mark);
+    arena.shrink(1024);
+    EXPECT_EQ(512u, arena.capacity());
+    // The first block holds the 100 bytes before the mark.
+    arena.shrink(0);
+    EXPECT_EQ(256u, arena.capacity());
+    arena.allocate(5000);
+    EXPECT_GT(arena.capacity(), 5000u);
+}
+
+TEST(arena, outermost_scope_trims_the_scratch_arena) {
+    std::thread thread([]() {
+        size_t max_bytes = ArenaScope::kMaxRetainedBytes;
+        {
+            ArenaScope outer;
+            {
+                ArenaScope inner;
+                ArenaVector<char> large = inner.vector<char>();
+                large.resize(4 * max_bytes);
+            }
+            // Still within a scope: nothing is freed yet.
+            EXPECT_GT(scratch_arena().capacity(), 4 * max_bytes);
+        }
+        EXPECT_LE(scratch_arena().capacity(), max_bytes);
+    });
+    thread.join();
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bit_vector.hpp"
+#include "text.hpp"
+#include "transformer.hpp"
+
+using transformer::BitVector;
+using transformer::Binarizer;
+using transformer::MultiHotBinarizer;
+using transformer::make_lazy_transformer;
+using transformer::make_transformer;
+
+namespace {
+
+BitVector random_bits(size_t size, std::mt19937* rng) {
+    BitVector bits(size);
+    for (size_t i = 0; i < size; i++) {
+        if ((*rng)() % 3 == 0) {
+            bits.set(i);
+        }
+    }
+    return bits;
+}
+}
+
+TEST(bit_vector, set_test_count) {
+    BitVector bits(130);
+    EXPECT_EQ(130, bits.size());
+    EXPECT_EQ(3, bits.words().size());
+    bits.set(0);
+    bits.set(64);
+    bits.set(129);
+    EXPECT_TRUE(bits.test(64));
+    EXPECT_FALSE(bits[63]);
+    EXPECT_EQ(3, bits.count());
+    bits.reset(64);
+    EXPECT_EQ(2, bits.count());
+
+    BitVector other(130);
+    other.set(129);
+    other.set(5);
+    EXPECT_EQ(1, bits.count_and(other));
+    EXPECT_THROW(bits.count_and(BitVector(3)), std::invalid_argument);
+
+    std::vector<size_t> indices;
+    for_each_nonzero(bits, [&](size_t i, double value) {
+        EXPECT_EQ(1.0, value);
+        indices.push_back(i);
+    });
+    EXPECT_EQ(std::vector<size_t>({0, 129}), indices);
+}
+
+TEST(bit_vector, combine_matches_dense) {
+    std::mt19937 rng(7);
+    size_t sizes[] = {0, 1, 5, 63, 64, 65, 128, 200};
+    for (size_t first_size : sizes) {
+        for (size_t second_size : sizes) {
+            BitVector first = random_bits(first_size, &rng);
+            BitVector second = random_bits(second_size, &rng);
+            std::vector<double> expected = first.to_dense();
+            std::vector<double> second_dense = second.to_dense();
+            expected.insert(expected.end(), second_dense.begin(),
+                    second_dense.end());
+
+            BitVector combined = transformer::combine(std::move(first),
+                    std::move(second));
+            EXPECT_EQ(expected, combined.to_dense());
+            EXPECT_EQ((expected.size() + 63) / 64, combined.words().size());
+        }
+    }
+}
+
+TEST(bit_vector, binarizers_emit_bits) {
+    auto identity = make_lazy_transformer<std::string, std::string>(
+            [](const std::string& s) { return s; });
+    auto both = (identity + make_transformer<Binarizer<std::string, bool>>()) |
+        make_transformer<Binarizer<std::string, bool>>();
+    both->step("a");
+    both->step("b");
+    both->step("c");
+    both->finalize();
+    BitVector bits = both->transform("b");
+    EXPECT_EQ(6, bits.size());
+    EXPECT_EQ(std::vector<double>({0, 1, 0, 0, 1, 0}), bits.to_dense());
+
+    MultiHotBinarizer<std::string, bool> multi_hot;
+    multi_hot.step({"x", "y", "z"});
+    multi_hot.finalize();
+    EXPECT_EQ(std::vector<double>({1, 0, 1}),
+            multi_hot.transform({"z", "x", "unseen"}).to_dense());
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+#include "concurrent_binarizer.hpp"
+
+using transformer::Binarizer;
+using transformer::ConcurrentBinarizer;
+using transformer::FeatureValue;
+
+TEST(concurrent_binarizer, matches_single_threaded_fit) {
+    std::vector<std::string> data;
+    for (int i = 0; i < 4000; i++) {
+        data.push_back(std::to_string((i * 7919) % 613));
+    }
+
+    Binarizer<std::string> expected;
+    expected.step_batch(data);
+    expected.finalize();
+
+    ConcurrentBinarizer<std::string> binarizer(8);
+    std::vector<std::thread> readers;
+    size_t chunk = data.size() / 4;
+    for (size_t t = 0; t < 4; t++) {
+        readers.emplace_back([&binarizer, &data, chunk, t]() {
+            size_t begin = t * chunk;
+            // Half of the chunk row by row, the rest as one batch.
+            for (size_t i = begin; i < begin + chunk / 2; i++) {
+                binarizer.step(data[i], i);
+            }
+            binarizer.step_batch(std::vector<std::string>(
+                        data.begin() + begin + chunk / 2,
+                        data.begin() + begin + chunk), begin + chunk / 2);
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    binarizer.finalize();
+
+    EXPECT_TRUE(binarizer.is_finalized());
+    for (const auto& value : {"0", "1", "42", "612"}) {
+        EXPECT_EQ(expected.transform(value), binarizer.transform(value));
+    }
+}
+
+TEST(concurrent_binarizer, extend_appends_new_levels) {
+    ConcurrentBinarizer<std::string> binarizer;
+    binarizer.step_batch({"b", "a"});
+    binarizer.finalize();
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1}), binarizer.transform("a"));
+
+    binarizer.extend();
+    EXPECT_FALSE(binarizer.is_finalized());
+    binarizer.step("c", 0);
+    binarizer.step("a", 1);
+    binarizer.finalize();
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1, 0}), binarizer.transform("a"));
+    EXPECT_EQ(std::vector<FeatureValue>({0, 0, 1}), binarizer.transform("c"));
+}
+
+TEST(concurrent_binarizer, zero_shards_means_one) {
+    ConcurrentBinarizer<std::string> binarizer(0);
+    binarizer.step_batch({"x", "y", "x"});
+    binarizer.finalize();
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1}), binarizer.transform("y"));
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <string>
+
+#include "count_encoder.hpp"
+
+using transformer::CountEncoder;
+using transformer::Counting;
+
+TEST(count_encoder, exact_counts) {
+    CountEncoder<std::string> encoder;
+    CountEncoder<std::string> shard;
+    encoder.step_batch({"a", "b", "a"});
+    shard.step_batch({"a", "c"});
+    encoder.merge(shard);
+    encoder.finalize();
+    EXPECT_EQ(5, encoder.total());
+    EXPECT_EQ(std::vector<double>({3, 1, 1, 0}),
+            encoder.transform_batch({"a", "b", "c", "unseen"}));
+
+    CountEncoder<std::string> log(CountEncoder<std::string>::Log);
+    log.step_batch({"a", "a", "b"});
+    log.finalize();
+    EXPECT_DOUBLE_EQ(std::log1p(2), log.transform("a"));
+
+    CountEncoder<std::string> normalized(
+            CountEncoder<std::string>::Normalized);
+    normalized.step_batch({"a", "a", "b", "c"});
+    normalized.finalize();
+    EXPECT_DOUBLE_EQ(0.5, normalized.transform("a"));
+
+    // Counts go on after extend.
+    normalized.extend();
+    normalized.step_batch({"b", "b", "b", "b"});
+    normalized.finalize();
+    EXPECT_DOUBLE_EQ(0.625, normalized.transform("b"));
+}
+
+TEST(count_encoder, sketch_counts_in_fixed_memory) {
+    CountEncoder<uint64_t> sketch(CountEncoder<uint64_t>::Raw,
+            Counting::Sketch, 1 << 10, 4);
+    CountEncoder<uint64_t> shard(CountEncoder<uint64_t>::Raw,
+            Counting::Sketch, 1 << 10, 4);
+    for (uint64_t i = 0; i < 20000; i++) {
+        (i % 2 ? sketch : shard).step(i % 2000);
+    }
+    sketch.merge(shard);
+    sketch.finalize();
+    size_t exact = 0;
+    for (uint64_t id = 0; id < 2000; id++) {
+        double count = sketch.transform(id);
+        EXPECT_GE(count, 10);
+        EXPECT_LE(count, 10 + 20000 * std::exp(1) / 1024);
+        exact += count == 10;
+    }
+    EXPECT_GT(exact, 600);
+    EXPECT_THROW(sketch.merge(CountEncoder<uint64_t>()),
+            std::invalid_argument);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "csv.hpp"
+#include "standardizer.hpp"
+#include "temp_file.hpp"
+
+using transformer::CsvReader;
+using transformer::CsvRow;
+using transformer::Standardizer;
+using transformer::StringView;
+using transformer::make_lazy_transformer;
+using transformer::make_transformer;
+
+namespace {
+
+std::vector<std::string> strings(const CsvRow& row) {
+    std::vector<std::string> output;
+    for (const StringView& field : row.fields()) {
+        output.push_back(field.str());
+    }
+    return output;
+}
+}
+
+TEST(csv, quoting_and_line_breaks) {
+    TempFile file("name,comment,n\r\n"
+            "a,plain,1\r\n"
+            "\n"
+            "b,\"with, comma\",2\n"
+            "c,\"line\nbreak and \"\"quotes\"\"\",3\r"
+            "d,,\n"
+            "e,\"\"\"\",5");
+    CsvReader reader(file.path(), ',', true);
+    EXPECT_EQ(std::vector<std::string>({"name", "comment", "n"}),
+            reader.header());
+    EXPECT_EQ(1, reader.column("comment"));
+
+    std::vector<std::vector<std::string>> rows;
+    CsvRow row;
+    while (reader.read_row(&row)) {
+        rows.push_back(strings(row));
+    }
+    ASSERT_EQ(5, rows.size());
+    EXPECT_EQ(std::vector<std::string>({"a", "plain", "1"}), rows[0]);
+    EXPECT_EQ(std::vector<std::string>({"b", "with, comma", "2"}), rows[1]);
+    EXPECT_EQ(std::vector<std::string>({"c", "line\nbreak and \"quotes\"",
+                "3"}), rows[2]);
+    EXPECT_EQ(std::vector<std::string>({"d", "", ""}), rows[3]);
+    EXPECT_EQ(std::vector<std::string>({"e", "\"", "5"}), rows[4]);
+
+    // Copies keep their unescaped fields.
+    CsvReader again(file.path(), ',', true);
+    std::vector<CsvRow> batch;
+    ASSERT_TRUE(again.read_batch(&batch, 3));
+    ASSERT_EQ(3, batch.size());
+    CsvRow copy = batch[2];
+    batch.clear();
+    EXPECT_EQ("line\nbreak and \"quotes\"", copy[1].str());
+}
+
+TEST(csv, tsv_feeds_transformers) {
+    TempFile file("x\ty\n1\ta\n2\tb\n3\tc\n4\td\n");
+    CsvReader reader(file.path(), '\t', true);
+    size_t x = reader.column("x");
+    auto standardizer = make_lazy_transformer<CsvRow, double>(
+            [x](const CsvRow& row) { return std::stod(row[x].str()); }) +
+        make_transformer<Standardizer<double>>();
+    std::vector<CsvRow> batch;
+    while (reader.read_batch(&batch, 3)) {
+        standardizer->step_batch(batch);
+    }
+    standardizer->finalize();
+    EXPECT_TRUE(batch.empty());
+    CsvReader second(file.path(), '\t', true);
+    second.read_batch(&batch);
+    auto out = standardizer->transform_batch(batch);
+    ASSERT_EQ(4, out.size());
+    EXPECT_NEAR(0, out[0] + out[3], 1e-12);
+    EXPECT_LT(out[0], out[1]);
+}
+
+TEST(csv, parallel_chunks_match_sequential) {
+    std::string content;
+    long expected_sum = 0;
+    for (int i = 0; i < 50000; i++) {
+        content += std::to_string(i) + ",";
+        content += i % 7 ? "word" : "\"multi\nline, \"\"quoted\"\"\"";
+        content += i % 3 ? "\n" : "\r\n";
+        expected_sum += i;
+    }
+    TempFile file(content);
+    CsvReader reader(file.path());
+    std::atomic<long> sum(0);
+    std::atomic<size_t> rows(0);
+    std::atomic<size_t> quoted(0);
+    reader.for_each_batch(4, 1000, [&](const std::vector<CsvRow>& batch) {
+        for (const CsvRow& row : batch) {
+            ASSERT_EQ(2, row.size());
+            sum += std::stol(row[0].str());
+            quoted += row[1] == StringView("multi\nline, \"quoted\"");
+        }
+        rows += batch.size();
+    });
+    EXPECT_EQ(50000, rows);
+    EXPECT_EQ(expected_sum, sum);
+    EXPECT_EQ(50000 / 7 + 1, quoted);
+}
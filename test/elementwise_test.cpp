@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <string>
+#include <type_traits>
+
+#include "numeric.hpp"
+#include "standardizer.hpp"
+
+using transformer::Clip;
+using transformer::FusedElementwise;
+using transformer::Log1p;
+using transformer::MinMaxScaler;
+using transformer::Standardizer;
+using transformer::make_lazy_transformer;
+using transformer::make_transformer;
+
+namespace {
+
+std::vector<double> samples(size_t n) {
+    std::vector<double> output;
+    for (size_t i = 0; i < n; i++) {
+        output.push_back((i * 37) % 1000 * 0.5);
+    }
+    return output;
+}
+
+void expect_near(const std::vector<double>& expected,
+        const std::vector<double>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_NEAR(expected[i], actual[i], 1e-12) << i;
+    }
+}
+}
+
+TEST(elementwise, fuse_folds_affine_stages) {
+    auto log1p = make_transformer<Log1p<double>>();
+    auto standardizer = make_transformer<Standardizer<double>>();
+    auto scaler = make_transformer<MinMaxScaler<double>>();
+    auto clip = make_transformer<Clip<double>>(0.1, 0.9);
+    auto data = samples(2000);
+    standardizer->step_batch(log1p->transform_batch(data));
+    standardizer->finalize();
+    scaler->step_batch(standardizer->transform_batch(
+                log1p->transform_batch(data)));
+    scaler->finalize();
+
+    auto expected = clip->transform_batch(scaler->transform_batch(
+                standardizer->transform_batch(log1p->transform_batch(data))));
+    auto chain = log1p + standardizer + scaler + clip;
+    expect_near(expected, chain->transform_batch(data));
+    EXPECT_NEAR(expected[3], chain->transform(data[3]), 1e-12);
+
+    // log1p, one multiply-add for both scalers, clip, log1p.
+    auto fused = std::dynamic_pointer_cast<FusedElementwise<double>>(
+            chain->fuse(make_transformer<Log1p<double>>()));
+    ASSERT_TRUE(fused != nullptr);
+    EXPECT_EQ(4, fused->num_ops());
+}
+
+TEST(elementwise, pipeline_fuses_once_fitted) {
+    auto parse = make_lazy_transformer<std::string, double>(
+            [](const std::string& s) { return std::stod(s); });
+    auto standardizer = make_transformer<Standardizer<double>>();
+    auto chain = parse + make_transformer<Log1p<double>>() + standardizer +
+        make_transformer<Clip<double>>(-1, 1);
+    EXPECT_FALSE(chain->is_finalized());
+    chain->step_batch({"0", "1", "10", "100"});
+    chain->finalize();
+    double mean = (std::log1p(0) + std::log1p(1) + std::log1p(10) +
+            std::log1p(100)) / 4;
+    double scale = standardizer->transform(1) - standardizer->transform(0);
+    EXPECT_NEAR((std::log1p(3) - mean) * scale, chain->transform("3"), 1e-12);
+    EXPECT_EQ(std::vector<double>({-1, 1}),
+            chain->transform_batch({"0", "1000000"}));
+
+    // Refitted parameters are picked up by the next fusion.
+    chain->extend();
+    chain->step_batch({"1000", "10000"});
+    chain->finalize();
+    double shifted = standardizer->transform(std::log1p(3));
+    EXPECT_NEAR(shifted, chain->transform("3"), 1e-12);
+    EXPECT_LT(shifted, -0.5);
+}
+
+TEST(elementwise, rvalue_batch_in_place) {
+    auto pipe = make_transformer<MinMaxScaler<double>>() +
+        make_transformer<Log1p<double>>();
+    std::vector<double> batch = samples(1000);
+    for (double x : batch) {
+        pipe->step(x);
+    }
+    pipe->finalize();
+    std::vector<double> expected = pipe->transform_batch(batch);
+
+    const double* data = batch.data();
+    std::vector<double> output = pipe->transform_batch(std::move(batch));
+    EXPECT_EQ(data, output.data());
+    expect_near(expected, output);
+}
+
+TEST(elementwise, float_chain_runs_in_float) {
+    auto data = samples(2000);
+    std::vector<float> float_data(data.begin(), data.end());
+    auto chain = make_transformer<Log1p<double>>() +
+        make_transformer<Standardizer<double>>() +
+        make_transformer<Clip<double>>(-1, 1);
+    auto float_chain = make_transformer<Log1p<float>>() +
+        make_transformer<Standardizer<float>>() +
+        make_transformer<Clip<float>>(-1, 1);
+    chain->step_batch(data);
+    float_chain->step_batch(float_data);
+    chain->finalize();
+    float_chain->finalize();
+
+    auto expected = chain->transform_batch(data);
+    auto output = float_chain->transform_batch(float_data);
+    static_assert(std::is_same<std::vector<float>, decltype(output)>::value,
+            "float in, float out");
+    ASSERT_EQ(expected.size(), output.size());
+    for (size_t i = 0; i < output.size(); i++) {
+        EXPECT_NEAR(expected[i], output[i], 1e-5) << i;
+    }
+    EXPECT_TRUE(std::dynamic_pointer_cast<FusedElementwise<float>>(
+                float_chain->fuse(make_transformer<Log1p<float>>())) !=
+            nullptr);
+}
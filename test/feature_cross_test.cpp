@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <tuple>
+
+#include "feature_cross.hpp"
+
+using transformer::Binarizer;
+using transformer::FeatureCross;
+using transformer::FeatureValue;
+using transformer::SparseVector;
+using transformer::make_lazy_transformer;
+using transformer::make_transformer;
+
+namespace {
+
+struct Data {
+    std::string firstname;
+    std::string lastname;
+    int age;
+};
+}
+
+TEST(feature_cross, crosses_categorical_columns) {
+    std::function<std::string(const Data&)> firstname =
+        [](const Data& sample) { return sample.firstname; };
+    std::function<std::string(const Data&)> lastname =
+        [](const Data& sample) { return sample.lastname; };
+    std::function<int(const Data&)> age =
+        [](const Data& sample) { return sample.age; };
+    auto cross = (make_lazy_transformer(firstname) |
+            make_lazy_transformer(lastname) | make_lazy_transformer(age)) +
+        make_transformer<FeatureCross<std::tuple<std::string, std::string,
+            int>>>(1024);
+
+    std::vector<Data> dataset = {{"Mike", "Jordan", 30}, {"Mike", "James", 30},
+        {"Bill", "Jordan", 30}, {"Bill", "James", 30}, {"Mike", "Jordan", 31}};
+    std::set<uint32_t> buckets;
+    for (const auto& data : dataset) {
+        SparseVector<double> out = cross->transform(data);
+        EXPECT_EQ(1024, out.dim);
+        ASSERT_EQ(1, out.nnz());
+        EXPECT_EQ(1, out.values[0]);
+        buckets.insert(out.indices[0]);
+    }
+    EXPECT_EQ(5, buckets.size());
+    EXPECT_EQ(cross->transform(dataset[0]), cross->transform(dataset[0]));
+
+    // Order matters.
+    FeatureCross<std::tuple<std::string, std::string>> pair_cross;
+    EXPECT_NE(pair_cross.transform(std::make_tuple("a", "b")),
+            pair_cross.transform(std::make_tuple("b", "a")));
+}
+
+TEST(feature_cross, crosses_non_zeros_of_vectors) {
+    SparseVector<double> bins(4);
+    bins.push_back(1, 2);
+    bins.push_back(3, 0.5);
+    std::vector<double> one_hot = {0, 1, 0};
+    FeatureCross<std::tuple<SparseVector<double>, std::vector<double>>> cross(
+            1 << 16);
+    auto out = cross.transform(std::make_tuple(bins, one_hot));
+    ASSERT_EQ(2, out.nnz());
+    EXPECT_LT(out.indices[0], out.indices[1]);
+    std::multiset<double> values(out.values.begin(), out.values.end());
+    EXPECT_EQ(std::multiset<double>({0.5, 2}), values);
+
+    // Everything in one bucket adds up.
+    FeatureCross<std::tuple<SparseVector<double>, std::vector<double>>> tiny(
+            1);
+    auto summed = tiny.transform(std::make_tuple(bins, one_hot));
+    ASSERT_EQ(1, summed.nnz());
+    EXPECT_EQ(2.5, summed.values[0]);
+
+    // An empty input crosses to nothing.
+    EXPECT_EQ(0, cross.transform(std::make_tuple(SparseVector<double>(4),
+                    one_hot)).nnz());
+}
+
+TEST(feature_cross, follows_binarizer) {
+    auto binarizer = make_transformer<Binarizer<std::string>>();
+    auto pipe = binarizer + make_transformer<FeatureCross<
+        std::vector<FeatureValue>>>(64);
+    pipe->step_batch({"x", "y", "z"});
+    pipe->finalize();
+    EXPECT_NE(pipe->transform("x"), pipe->transform("y"));
+    EXPECT_EQ(1, pipe->transform("z").nnz());
+}
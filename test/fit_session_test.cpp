@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "fit_session.hpp"
+#include "transformer.hpp"
+
+using transformer::Binarizer;
+using transformer::FeatureValue;
+using transformer::FitSession;
+using transformer::TransformFunc;
+using transformer::make_lazy_transformer;
+using transformer::make_transformer;
+
+namespace {
+
+struct Person {
+    std::string firstname;
+    std::string lastname;
+};
+
+TransformFunc<Person, std::string> firstname_func =
+    [](const Person& sample) -> std::string {
+        return sample.firstname;
+    };
+TransformFunc<Person, std::string> lastname_func =
+    [](const Person& sample) -> std::string {
+        return sample.lastname;
+    };
+
+std::vector<Person> people() {
+    return {{"Mike", "Jordan"}, {"Mike", "James"}, {"Bill", "Jordan"},
+        {"Bill", "James"}, {"Anna", "Smith"}};
+}
+
+void fit_with_session(size_t num_threads) {
+    auto firstname = make_lazy_transformer(firstname_func);
+    auto lastname = make_lazy_transformer(lastname_func);
+    auto first_pipe = firstname + make_transformer<Binarizer<std::string>>();
+    auto last_pipe = lastname + make_transformer<Binarizer<std::string>>();
+    auto both_pipe = (firstname | lastname) +
+        make_transformer<Binarizer<std::tuple<std::string, std::string>>>();
+
+    FitSession<Person> session(num_threads);
+    session.add(first_pipe);
+    session.add(last_pipe);
+    session.add(both_pipe);
+    EXPECT_EQ(3, session.size());
+
+    auto data = people();
+    session.step(data[0]);
+    session.step_batch(std::vector<Person>(data.begin() + 1, data.end()));
+    session.finalize();
+
+    EXPECT_TRUE(first_pipe->is_finalized());
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1, 0}),
+            first_pipe->transform(data[2]));
+    EXPECT_EQ(std::vector<FeatureValue>({0, 0, 1}),
+            last_pipe->transform(data[4]));
+    EXPECT_EQ(5, both_pipe->transform(data[3]).size());
+    EXPECT_EQ(1.0, both_pipe->transform(data[3])[3]);
+}
+}
+
+TEST(fit_session, sequential) {
+    fit_with_session(1);
+}
+
+TEST(fit_session, threaded) {
+    fit_with_session(4);
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+
+#include "flat_map.hpp"
+
+using transformer::FlatHashMap;
+
+TEST(flat_map, matches_std_map) {
+    FlatHashMap<uint64_t, int> map;
+    std::map<uint64_t, int> expected;
+    for (uint64_t i = 0; i < 10000; i++) {
+        uint64_t key = (i * 2654435761u) % 3000;
+        map[key] += 1;
+        expected[key] += 1;
+    }
+    EXPECT_EQ(expected.size(), map.size());
+    for (const auto& entry : expected) {
+        const int* value = map.find(entry.first);
+        ASSERT_TRUE(value != nullptr);
+        EXPECT_EQ(entry.second, *value);
+    }
+    EXPECT_TRUE(map.find(3001) == nullptr);
+
+    size_t visited = 0;
+    map.for_each([&](uint64_t key, int value) {
+        EXPECT_EQ(expected[key], value);
+        visited++;
+    });
+    EXPECT_EQ(expected.size(), visited);
+}
+
+TEST(flat_map, string_keys) {
+    FlatHashMap<std::string, double> map;
+    map.reserve(100);
+    map["a"] = 1;
+    map["b"] = 2;
+    map["a"] += 1;
+    EXPECT_EQ(2, map.size());
+    EXPECT_EQ(2, *map.find("a"));
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.find("a") == nullptr);
+}
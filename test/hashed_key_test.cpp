@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "count_encoder.hpp"
+#include "feature_cross.hpp"
+#include "hashed_key.hpp"
+#include "text.hpp"
+#include "transformer.hpp"
+
+using transformer::Binarizer;
+using transformer::CountEncoder;
+using transformer::Counting;
+using transformer::FastHash;
+using transformer::FeatureCross;
+using transformer::FeatureValue;
+using transformer::HashKey;
+using transformer::HashKeys;
+using transformer::HashedKey;
+using transformer::MultiHotBinarizer;
+using transformer::SparseVector;
+using transformer::make_lazy_transformer;
+using transformer::make_transformer;
+
+namespace {
+
+int num_hashed = 0;
+
+struct Word {
+    std::string text;
+
+    bool operator==(const Word& other) const {
+        return text == other.text;
+    }
+};
+}
+
+namespace transformer {
+
+template<>
+struct HashAppend<Word> {
+    static void apply(HashState* state, const Word& word) {
+        num_hashed++;
+        HashAppend<std::string>::apply(state, word.text);
+    }
+};
+} // namespace: transformer
+
+TEST(hashed_key, consumers_reuse_the_hash) {
+    std::vector<Word> words = {{"apple"}, {"pear"}, {"apple"}};
+    // The hash of Word(), for empty slots, is computed on first use.
+    HashedKey<Word> empty;
+    num_hashed = 0;
+    std::vector<HashedKey<Word>> keys;
+    for (const Word& word : words) {
+        keys.emplace_back(word);
+    }
+    EXPECT_EQ(3, num_hashed);
+
+    Binarizer<HashedKey<Word>> binarizer;
+    CountEncoder<HashedKey<Word>> exact;
+    CountEncoder<HashedKey<Word>> sketch(CountEncoder<HashedKey<Word>>::Raw,
+            Counting::Sketch, 1024, 4);
+    FeatureCross<HashedKey<Word>> cross(64);
+    binarizer.step_batch(keys);
+    exact.step_batch(keys);
+    sketch.step_batch(keys);
+    binarizer.finalize();
+    exact.finalize();
+    sketch.finalize();
+    EXPECT_EQ(std::vector<FeatureValue>({1, 0}), binarizer.transform(keys[2]));
+    EXPECT_EQ(2, exact.transform(keys[0]));
+    EXPECT_EQ(2, sketch.transform(keys[2]));
+    SparseVector<double> crossed = cross.transform(keys[1]);
+    EXPECT_EQ(3, num_hashed);
+
+    // The same buckets and counters as the values themselves.
+    CountEncoder<Word> plain_sketch(CountEncoder<Word>::Raw,
+            Counting::Sketch, 1024, 4);
+    plain_sketch.step_batch(words);
+    plain_sketch.finalize();
+    EXPECT_EQ(plain_sketch.transform(words[1]), sketch.transform(keys[1]));
+    EXPECT_EQ(FeatureCross<Word>(64).transform(words[1]).indices,
+            crossed.indices);
+}
+
+TEST(hashed_key, equality_and_composite_keys) {
+    HashedKey<std::string> a("a");
+    EXPECT_EQ(FastHash<std::string>()("a"), a.hash());
+    EXPECT_EQ(a.hash(), std::hash<HashedKey<std::string>>()(a));
+    EXPECT_EQ(HashedKey<std::string>("a"), a);
+    EXPECT_NE(HashedKey<std::string>("b"), a);
+
+    FastHash<std::tuple<HashedKey<std::string>, int>> tuple_hash;
+    EXPECT_EQ(tuple_hash(std::make_tuple(a, 1)),
+            tuple_hash(std::make_tuple(HashedKey<std::string>("a"), 1)));
+    EXPECT_NE(tuple_hash(std::make_tuple(a, 1)),
+            tuple_hash(std::make_tuple(a, 2)));
+}
+
+TEST(hashed_key, hash_key_stages) {
+    std::function<std::string(const std::string&)> identity =
+        [](const std::string& s) { return s; };
+    auto binarize = make_lazy_transformer(identity) +
+        make_transformer<HashKey<std::string>>() +
+        make_transformer<Binarizer<HashedKey<std::string>>>();
+    binarize->step_batch({"x", "y", "x"});
+    binarize->finalize();
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1}), binarize->transform("y"));
+
+    auto multi_hot = make_transformer<HashKeys<std::string>>() +
+        make_transformer<MultiHotBinarizer<HashedKey<std::string>>>();
+    multi_hot->step({"to", "be", "or"});
+    multi_hot->finalize();
+    std::vector<std::string> tokens = {"or", "not"};
+    EXPECT_EQ(std::vector<FeatureValue>({0, 0, 1}),
+            multi_hot->transform(std::move(tokens)));
+}
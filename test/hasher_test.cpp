@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+
+#include "hasher.hpp"
+#include "string_view.hpp"
+#include "transformer.hpp"
+
+using transformer::Binarizer;
+using transformer::FastHash;
+using transformer::FeatureValue;
+using transformer::StringView;
+
+TEST(hasher, std_pair_and_array_are_ordered) {
+    std::hash<std::pair<int, int>> pair_hash;
+    EXPECT_NE(pair_hash(std::make_pair(1, 2)), pair_hash(std::make_pair(2, 1)));
+    EXPECT_NE(0, pair_hash(std::make_pair(7, 7)));
+    EXPECT_NE(pair_hash(std::make_pair(7, 7)), pair_hash(std::make_pair(8, 8)));
+
+    std::hash<std::array<int, 3>> array_hash;
+    EXPECT_NE(array_hash({{1, 2, 3}}), array_hash({{3, 2, 1}}));
+}
+
+TEST(hasher, fast_hash_composite_keys) {
+    FastHash<std::tuple<std::string, std::string>> tuple_hash;
+    EXPECT_NE(tuple_hash(std::make_tuple("ab", "c")),
+            tuple_hash(std::make_tuple("a", "bc")));
+    EXPECT_EQ(tuple_hash(std::make_tuple("ab", "c")),
+            tuple_hash(std::make_tuple("ab", "c")));
+
+    FastHash<std::pair<int, int>> pair_hash;
+    EXPECT_NE(pair_hash(std::make_pair(1, 2)), pair_hash(std::make_pair(2, 1)));
+
+    EXPECT_EQ(FastHash<double>()(0.0), FastHash<double>()(-0.0));
+    std::string text("a string longer than sixteen bytes");
+    EXPECT_EQ(FastHash<std::string>()(text),
+            FastHash<StringView>()(StringView(text)));
+    EXPECT_NE(FastHash<std::string>()(text),
+            FastHash<std::string>()(text.substr(1)));
+}
+
+TEST(hasher, fast_hash_spreads_low_bits) {
+    // A grid of small pairs into 2^12 buckets: about as many distinct
+    // buckets as a random function would fill.
+    FastHash<std::pair<int, int>> hash;
+    std::unordered_set<size_t> buckets;
+    for (int i = 0; i < 64; i++) {
+        for (int j = 0; j < 64; j++) {
+            buckets.insert(hash(std::make_pair(i, j)) & 4095);
+        }
+    }
+    // 4096 keys into 4096 buckets fill 1 - 1/e of them, ~2589.
+    EXPECT_GT(buckets.size(), 2450u);
+}
+
+TEST(hasher, binarizer_hash_policy) {
+    Binarizer<std::pair<int, int>> fast;
+    Binarizer<std::pair<int, int>, FeatureValue, std::hash> standard;
+    for (int i = 0; i < 10; i++) {
+        fast.step(std::make_pair(i, i));
+        standard.step(std::make_pair(i, i));
+    }
+    fast.finalize();
+    standard.finalize();
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(standard.transform(std::make_pair(i, i)),
+                fast.transform(std::make_pair(i, i)));
+    }
+}
+
+TEST(hasher, portable_multiply_fold) {
+    std::mt19937_64 rng(3);
+    uint64_t edges[] = {0, 1, 0xffffffffULL, 0x100000000ULL, ~0ULL};
+    for (uint64_t a : edges) {
+        for (uint64_t b : edges) {
+            EXPECT_EQ(transformer::multiply_fold(a, b),
+                    transformer::multiply_fold_portable(a, b));
+        }
+    }
+    for (int i = 0; i < 1000; i++) {
+        uint64_t a = rng(), b = rng();
+        EXPECT_EQ(transformer::multiply_fold(a, b),
+                transformer::multiply_fold_portable(a, b));
+    }
+}
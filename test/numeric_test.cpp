@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "numeric.hpp"
+
+using transformer::Clip;
+using transformer::Log1p;
+using transformer::MinMaxScaler;
+using transformer::PowerTransformer;
+namespace simd = transformer::simd;
+
+namespace {
+
+// Run func on every SIMD level the CPU has, ending with the best one.
+template<typename Func>
+void for_each_level(Func func) {
+    simd::Level detected = simd::detect_level();
+    for (int level = 0; level <= static_cast<int>(detected); level++) {
+        simd::set_level(static_cast<simd::Level>(level));
+        func();
+    }
+}
+}
+
+TEST(numeric, log1p_accurate_and_same_on_every_level) {
+    std::vector<double> samples = {0, -0.0, 1e-300, 1e-20, -1e-10, 0.5, 1,
+        M_SQRT2 - 1, 2, 3.5, 1e5, 1e300, -0.5, -0.999999, 7e-9};
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> exponent(-20, 20);
+    for (int i = 0; i < 1000; i++) {
+        samples.push_back(std::pow(10, exponent(rng)) * (i % 7 ? 1 : -1e-21));
+    }
+    Log1p<double> log1p;
+    std::vector<double> expected;
+    for (double x : samples) {
+        double out = log1p.transform(x);
+        double ulp = std::fabs(std::nextafter(std::log1p(x), HUGE_VAL) -
+                std::log1p(x));
+        EXPECT_LE(std::fabs(out - std::log1p(x)), ulp) << x;
+        expected.push_back(out);
+    }
+    for_each_level([&]() {
+        EXPECT_EQ(expected, log1p.transform_batch(samples));
+    });
+
+    auto special = log1p.transform_batch({-1, -2, HUGE_VAL, 1, 2, 3, 4, 5});
+    EXPECT_EQ(-HUGE_VAL, special[0]);
+    EXPECT_TRUE(std::isnan(special[1]));
+    EXPECT_EQ(HUGE_VAL, special[2]);
+    EXPECT_DOUBLE_EQ(std::log(6), special[7]);
+}
+
+TEST(numeric, clip) {
+    Clip<double> clip(-1, 2);
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    for_each_level([&]() {
+        auto out = clip.transform_batch({-5, 0, 1.5, 3, nan, -1, 2, 9, 0.25});
+        EXPECT_EQ(std::vector<double>({-1, 0, 1.5, 2}),
+                std::vector<double>(out.begin(), out.begin() + 4));
+        EXPECT_TRUE(std::isnan(out[4]));
+        EXPECT_EQ(2, out[7]);
+    });
+    EXPECT_TRUE(std::isnan(clip.transform(nan)));
+}
+
+TEST(numeric, min_max_scaler) {
+    MinMaxScaler<double> scaler, shard;
+    scaler.step_batch({2, 4});
+    shard.step_batch({6, 3});
+    scaler.merge(shard);
+    scaler.finalize();
+    EXPECT_EQ(2, scaler.min());
+    EXPECT_EQ(6, scaler.max());
+    EXPECT_EQ(std::vector<double>({0, 0.5, 1, 1.5}),
+            scaler.transform_batch({2, 4, 6, 8}));
+
+    scaler.extend();
+    scaler.step(10);
+    scaler.finalize();
+    EXPECT_EQ(0.5, scaler.transform(6));
+}
+
+TEST(numeric, power_transformer) {
+    std::mt19937 rng(7);
+    std::normal_distribution<double> normal(1, 0.5);
+    PowerTransformer<double> box_cox(PowerTransformer<double>::BoxCox);
+    PowerTransformer<double> yeo_johnson;
+    std::vector<double> samples;
+    for (int i = 0; i < 5000; i++) {
+        samples.push_back(std::exp(normal(rng)));
+    }
+    box_cox.step_batch(samples);
+    yeo_johnson.step_batch(samples);
+    box_cox.finalize();
+    yeo_johnson.finalize();
+
+    // Log-normal data: Box-Cox should pick the log.
+    EXPECT_NEAR(0, box_cox.lambda(), 0.15);
+    EXPECT_LT(yeo_johnson.lambda(), 1);
+    auto out = box_cox.transform_batch(samples);
+    double mean = 0;
+    for (double x : out) {
+        mean += x / out.size();
+    }
+    EXPECT_NEAR(0, mean, 1e-9);
+    EXPECT_DOUBLE_EQ(box_cox.transform(samples[3]), out[3]);
+
+    EXPECT_THROW(box_cox.step(-1), std::domain_error);
+}
+
+TEST(numeric, float_kernels_same_on_every_level) {
+    std::vector<float> samples;
+    for (int i = 0; i < 1000; i++) {
+        samples.push_back((i * 37) % 101 * 0.25f);
+    }
+    Log1p<float> log1p;
+    Clip<float> clip(2, 20);
+    MinMaxScaler<float> scaler;
+    scaler.step_batch(samples);
+    scaler.finalize();
+
+    std::vector<float> log1p_expected, clip_expected, scaler_expected;
+    for (float x : samples) {
+        log1p_expected.push_back(log1p.transform(x));
+        clip_expected.push_back(clip.transform(x));
+        scaler_expected.push_back(scaler.transform(x));
+        EXPECT_FLOAT_EQ(static_cast<float>(std::log1p(x)),
+                log1p_expected.back());
+    }
+    for_each_level([&]() {
+        EXPECT_EQ(log1p_expected, log1p.transform_batch(samples));
+        EXPECT_EQ(clip_expected, clip.transform_batch(samples));
+        EXPECT_EQ(scaler_expected, scaler.transform_batch(samples));
+    });
+    EXPECT_EQ(0, scaler.transform(0));
+    EXPECT_EQ(1, scaler.transform(25));
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "online.hpp"
+
+using transformer::Binarizer;
+using transformer::FeatureValue;
+using transformer::OnlineTransformer;
+using transformer::Pipeline;
+using transformer::make_lazy_transformer;
+using transformer::make_transformer;
+
+TEST(online_transformer, serves_published_snapshot) {
+    OnlineTransformer<Binarizer<std::string>> online;
+    EXPECT_THROW(online.transform("a"), std::logic_error);
+
+    online.step("a");
+    online.step("b");
+    online.publish();
+    EXPECT_EQ(1, online.version());
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1}), online.transform("b"));
+
+    // Learning goes on, readers keep seeing the old snapshot.
+    online.step("c");
+    EXPECT_EQ(2, online.transform("b").size());
+    EXPECT_THROW(online.transform("c"), std::out_of_range);
+
+    online.publish();
+    EXPECT_EQ(std::vector<FeatureValue>({0, 0, 1}), online.transform("c"));
+}
+
+TEST(online_transformer, concurrent_readers_and_writer) {
+    OnlineTransformer<Binarizer<int>> online;
+    online.step(0);
+    online.publish();
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; t++) {
+        readers.emplace_back([&online, &done]() {
+            size_t last_size = 0;
+            while (!done.load()) {
+                auto out = online.transform(0);
+                // Snapshots only grow, and are never seen half-built.
+                EXPECT_LE(last_size, out.size());
+                EXPECT_EQ(1.0, out[0]);
+                last_size = out.size();
+            }
+        });
+    }
+    for (int i = 1; i <= 200; i++) {
+        online.step(i);
+        if (i % 10 == 0) {
+            online.publish();
+        }
+    }
+    done.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(201, online.transform(0).size());
+}
+
+TEST(online_transformer, composite_snapshot_owns_its_stages) {
+    typedef Pipeline<std::string, std::string, std::vector<FeatureValue>>
+        LevelPipeline;
+    auto lower = make_lazy_transformer<std::string, std::string>(
+            [](const std::string& text) {
+                std::string output(text);
+                for (char& c : output) {
+                    c = std::tolower(c);
+                }
+                return output;
+            });
+    auto levels = make_transformer<Binarizer<std::string>>() |
+        make_transformer<Binarizer<std::string>>();
+    OnlineTransformer<LevelPipeline> online(LevelPipeline(lower, levels));
+
+    online.step("A");
+    online.publish();
+    EXPECT_EQ(std::vector<FeatureValue>({1, 1}), online.transform("a"));
+
+    // Finalizing the snapshot finalized its own binarizers, the working ones
+    // keep learning.
+    online.step("B");
+    online.publish();
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1, 0, 1}), online.transform("b"));
+    EXPECT_FALSE(levels->is_finalized());
+}
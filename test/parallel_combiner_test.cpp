@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "parallel_combiner.hpp"
+#include "stream.hpp"
+
+using transformer::Binarizer;
+using transformer::FeatureValue;
+using transformer::ThreadPool;
+using transformer::TransformFunc;
+using transformer::make_lazy_transformer;
+using transformer::make_parallel_combiner;
+using transformer::make_stream;
+using transformer::make_transformer;
+
+namespace {
+
+/**
+ * Thread ids for the two branches, where the n-th call of the second
+ * branch only returns once the first branch has been called n times. Run
+ * concurrently, the second branch (on the caller) can't finish before the
+ * first has started on a pool thread, so the caller can't end up running
+ * the first branch itself.
+ */
+class BranchOrder {
+public:
+    std::thread::id first() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _first_calls++;
+        }
+        _cond.notify_all();
+        return std::this_thread::get_id();
+    }
+
+    std::thread::id second() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        size_t call = ++_second_calls;
+        // Generous, a deadlock fails the test rather than hanging it.
+        _cond.wait_for(lock, std::chrono::seconds(30),
+                [this, call]() { return _first_calls >= call; });
+        return std::this_thread::get_id();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    size_t _first_calls = 0;
+    size_t _second_calls = 0;
+};
+}
+
+TEST(parallel_combiner, same_output_as_combiner) {
+    auto pool = std::make_shared<ThreadPool>(2);
+    TransformFunc<std::string, std::string> upper =
+        [](const std::string& str) -> std::string {
+            return std::string(1, toupper(str[0]));
+        };
+    auto first = make_transformer<Binarizer<std::string>>();
+    auto second = make_lazy_transformer(upper) +
+        make_transformer<Binarizer<std::string>>();
+    // Tiny threshold, so step and transform go parallel once measured.
+    auto parallel = make_parallel_combiner(first, second, pool, 0);
+
+    std::vector<std::string> data = {"apple", "avocado", "banana"};
+    for (int round = 0; round < 3; round++) {
+        for (const auto& str : data) {
+            parallel->step(str);
+            parallel->step(std::string(str));
+        }
+    }
+    parallel->finalize();
+    std::string avocado = "avocado";
+    for (int round = 0; round < 3; round++) {
+        EXPECT_EQ(std::vector<FeatureValue>({0, 1, 0, 1, 0}),
+                parallel->transform(avocado));
+        EXPECT_EQ(std::vector<FeatureValue>({0, 1, 0, 1, 0}),
+                parallel->transform("avocado"));
+    }
+    EXPECT_EQ(std::vector<std::vector<FeatureValue>>(2, {0, 1, 0, 1, 0}),
+            parallel->transform_batch({"avocado", "avocado"}));
+}
+
+TEST(parallel_combiner, runs_branches_on_different_threads) {
+    auto pool = std::make_shared<ThreadPool>(1);
+    BranchOrder order;
+    TransformFunc<int, std::thread::id> first_id =
+        [&order](const int&) { return order.first(); };
+    TransformFunc<int, std::thread::id> second_id =
+        [&order](const int&) { return order.second(); };
+    auto first = make_lazy_transformer(first_id);
+    auto second = make_lazy_transformer(second_id);
+    auto combiner = make_parallel_combiner(first, second, pool);
+
+    // Cheap branches are run in sequence.
+    int sample = 0;
+    auto out = combiner->transform(sample);
+    EXPECT_EQ(std::get<0>(out), std::get<1>(out));
+
+    auto parallel = std::dynamic_pointer_cast<
+        transformer::ParallelCombiner<int, std::thread::id, std::thread::id>>(
+                combiner);
+    ASSERT_TRUE(parallel != nullptr);
+    parallel->set_cost_estimate(1e9, 1e9);
+    out = combiner->transform(sample);
+    EXPECT_NE(std::get<0>(out), std::get<1>(out));
+    EXPECT_EQ(std::this_thread::get_id(), std::get<1>(out));
+    out = combiner->transform(0);
+    EXPECT_NE(std::get<0>(out), std::get<1>(out));
+    EXPECT_EQ(std::this_thread::get_id(), std::get<1>(out));
+    auto batch = combiner->transform_batch(std::vector<int>({0, 1}));
+    for (const auto& row : batch) {
+        EXPECT_NE(std::get<0>(row), std::get<1>(row));
+    }
+}
+
+TEST(parallel_combiner, stream_batches_run_branches_concurrently) {
+    auto pool = std::make_shared<ThreadPool>(1);
+    BranchOrder order;
+    TransformFunc<int, std::thread::id> first_id =
+        [&order](const int&) { return order.first(); };
+    TransformFunc<int, std::thread::id> second_id =
+        [&order](const int&) { return order.second(); };
+    auto combiner = make_parallel_combiner(make_lazy_transformer(first_id),
+            make_lazy_transformer(second_id), pool);
+    std::dynamic_pointer_cast<transformer::ParallelCombiner<int,
+        std::thread::id, std::thread::id>>(combiner)->set_cost_estimate(
+                1e9, 1e9);
+
+    int next = 0;
+    size_t rows = 0;
+    make_stream(combiner, 2).run([&next](std::vector<int>& batch) {
+        for (int i = 0; i < 16 && next < 64; i++) {
+            batch.push_back(next++);
+        }
+        return !batch.empty();
+    }, [&rows](std::vector<std::tuple<std::thread::id,
+            std::thread::id>>&& batch) {
+        for (const auto& out : batch) {
+            EXPECT_NE(std::get<0>(out), std::get<1>(out));
+        }
+        rows += batch.size();
+    });
+    EXPECT_EQ(64, rows);
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+
+#include "quantile_binner.hpp"
+
+using transformer::KllSketch;
+using transformer::QuantileBinner;
+using transformer::SparseVector;
+
+TEST(kll_sketch, bounded_memory_and_accuracy) {
+    KllSketch sketch(200);
+    for (int i = 0; i < 100000; i++) {
+        sketch.push((i * 7919) % 100000);
+    }
+    EXPECT_EQ(100000, sketch.count());
+    EXPECT_LT(sketch.size(), 1000);
+    EXPECT_NEAR(50000, sketch.quantile(0.5), 2000);
+    EXPECT_NEAR(90000, sketch.quantile(0.9), 2000);
+    EXPECT_EQ(0, sketch.quantile(0));
+}
+
+TEST(quantile_binner, equal_frequency_bins) {
+    QuantileBinner<> binner(4);
+    QuantileBinner<> shard(4);
+    for (int i = 0; i < 10000; i++) {
+        (i % 3 ? binner : shard).step(i);
+    }
+    binner.merge(shard);
+    binner.finalize();
+
+    ASSERT_EQ(4, binner.num_bins());
+    EXPECT_NEAR(2500, binner.boundaries()[0], 200);
+    EXPECT_NEAR(5000, binner.boundaries()[1], 200);
+    EXPECT_NEAR(7500, binner.boundaries()[2], 200);
+    EXPECT_EQ(0, binner.transform(-1));
+    EXPECT_EQ(1, binner.transform(4000));
+    EXPECT_EQ(3, binner.transform(1e9));
+    EXPECT_EQ(std::vector<int>({0, 2, 3}),
+            binner.transform_batch({10, 6000, 9999}));
+}
+
+TEST(quantile_binner, few_distinct_values) {
+    QuantileBinner<> binner(10);
+    for (int i = 0; i < 100; i++) {
+        binner.step(i % 2);
+    }
+    binner.finalize();
+    EXPECT_EQ(2, binner.num_bins());
+    EXPECT_EQ(0, binner.transform(0));
+    EXPECT_EQ(1, binner.transform(1));
+}
+
+TEST(quantile_binner, eytzinger_search_matches_sorted_search) {
+    QuantileBinner<> binner(200);
+    for (int i = 0; i < 20000; i++) {
+        binner.step((i * 31) % 20000);
+    }
+    binner.finalize();
+    const auto& bounds = binner.boundaries();
+    ASSERT_GT(bounds.size(), 100);
+    for (double x = -10; x < 20010; x += 7.5) {
+        size_t expected = std::upper_bound(bounds.begin(), bounds.end(), x) -
+            bounds.begin();
+        EXPECT_EQ(expected, binner.bin(x));
+    }
+    for (double bound : bounds) {
+        size_t expected = std::upper_bound(bounds.begin(), bounds.end(),
+                bound) - bounds.begin();
+        EXPECT_EQ(expected, binner.bin(bound));
+    }
+}
+
+TEST(quantile_binner, sparse_one_hot) {
+    QuantileBinner<SparseVector<double>> binner(2);
+    binner.step_batch({1, 2, 3, 4});
+    binner.finalize();
+    auto out = binner.transform(4);
+    EXPECT_EQ(2, out.dim);
+    EXPECT_EQ(std::vector<double>({0, 1}), out.to_dense());
+}
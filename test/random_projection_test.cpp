@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+#include "random_projection.hpp"
+
+using transformer::RandomProjection;
+using transformer::SparseVector;
+
+namespace {
+
+double squared_norm(const std::vector<double>& v) {
+    double output = 0;
+    for (double x : v) {
+        output += x * x;
+    }
+    return output;
+}
+}
+
+TEST(random_projection, sparse_and_dense_agree) {
+    SparseVector<double> sparse(100000);
+    sparse.push_back(3, 1);
+    sparse.push_back(70000, -2.5);
+    sparse.push_back(99999, 0.5);
+    std::vector<double> dense = sparse.to_dense();
+
+    RandomProjection<SparseVector<double>> from_sparse(64);
+    RandomProjection<std::vector<double>> from_dense(64);
+    auto out = from_sparse.transform(sparse);
+    ASSERT_EQ(64, out.size());
+    auto dense_out = from_dense.transform(dense);
+    for (size_t j = 0; j < out.size(); j++) {
+        EXPECT_DOUBLE_EQ(out[j], dense_out[j]);
+    }
+    EXPECT_NE(out, RandomProjection<SparseVector<double>>(64, 1.0 / 3, 7)
+            .transform(sparse));
+}
+
+TEST(random_projection, batch_matches_samples) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<uint32_t> index(0, 5000);
+    std::vector<SparseVector<double>> samples;
+    for (int s = 0; s < 50; s++) {
+        SparseVector<double> sample(5001);
+        for (uint32_t i = index(rng) % 100; i <= 5000; i += 1 + index(rng)) {
+            sample.push_back(i, 1 + s % 3);
+        }
+        samples.push_back(sample);
+    }
+    RandomProjection<SparseVector<double>> projection(100, 0.1);
+    auto batch = projection.transform_batch(samples);
+    ASSERT_EQ(samples.size(), batch.size());
+    for (size_t s = 0; s < samples.size(); s++) {
+        auto single = projection.transform(samples[s]);
+        for (size_t j = 0; j < single.size(); j++) {
+            EXPECT_NEAR(single[j], batch[s][j], 1e-12);
+        }
+    }
+}
+
+TEST(random_projection, preserves_norms_on_average) {
+    RandomProjection<SparseVector<double>> projection(256);
+    double ratio = 0;
+    const int kSamples = 200;
+    for (int s = 0; s < kSamples; s++) {
+        SparseVector<double> one_hot(1000000);
+        one_hot.push_back(s * 4999, 1);
+        one_hot.push_back(s * 4999 + 1, 1);
+        ratio += squared_norm(projection.transform(one_hot)) / 2;
+    }
+    EXPECT_NEAR(1, ratio / kSamples, 0.05);
+}
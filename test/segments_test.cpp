@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "segments.hpp"
+#include "transformer.hpp"
+
+using transformer::Binarizer;
+using transformer::FeatureValue;
+using transformer::Segments;
+using transformer::make_lazy_transformer;
+using transformer::make_transformer;
+using transformer::segmented;
+
+TEST(segments, combine_moves_chunks) {
+    std::vector<double> a = {1, 2};
+    const double* a_data = a.data();
+    Segments<double> first(std::move(a));
+    Segments<double> combined = transformer::combine(std::move(first),
+            std::vector<double>({3}));
+    combined = transformer::combine(std::vector<double>(),
+            std::move(combined));
+    combined = transformer::combine(std::move(combined),
+            Segments<double>(std::vector<double>({0, 4})));
+
+    EXPECT_EQ(5, combined.size());
+    ASSERT_EQ(3, combined.segments().size());
+    EXPECT_EQ(a_data, combined.segments()[0].data());
+    EXPECT_EQ(std::vector<double>({1, 2, 3, 0, 4}), combined.to_vector());
+
+    float gathered[5];
+    combined.gather(gathered);
+    EXPECT_EQ(4.0f, gathered[4]);
+
+    std::vector<size_t> indices;
+    for_each_nonzero(combined, [&](size_t i, double) {
+        indices.push_back(i);
+    });
+    EXPECT_EQ(std::vector<size_t>({0, 1, 2, 4}), indices);
+}
+
+TEST(segments, combiner_outputs_segments) {
+    auto identity = make_lazy_transformer<std::string, std::string>(
+            [](const std::string& s) { return s; });
+    auto binarizer = identity + make_transformer<Binarizer<std::string>>();
+    auto length = make_lazy_transformer<std::string,
+            std::vector<FeatureValue>>([](const std::string& s) {
+                return std::vector<FeatureValue>(1, s.size());
+            });
+    auto all = segmented(binarizer) | length | binarizer;
+    all->step("a");
+    all->step("bb");
+    all->finalize();
+    // The lazy length transformer has no known output_dim.
+    EXPECT_EQ(0, all->output_dim());
+
+    Segments<FeatureValue> out = all->transform("bb");
+    EXPECT_EQ(3, out.segments().size());
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1, 2, 0, 1}), out.to_vector());
+
+    auto batch = all->transform_batch({"a", "bb"});
+    ASSERT_EQ(2, batch.size());
+    EXPECT_EQ(std::vector<FeatureValue>({1, 0, 1, 1, 0}), batch[0].to_vector());
+    EXPECT_EQ(out, batch[1]);
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdexcept>
+
+#include "standardizer.hpp"
+
+using transformer::Standardizer;
+namespace simd = transformer::simd;
+
+TEST(standardizer, scalar) {
+    Standardizer<double> standardizer;
+    standardizer.step_batch({1, 2, 3, 4});
+    standardizer.finalize();
+    EXPECT_DOUBLE_EQ(2.5, standardizer.moments().mean);
+    EXPECT_DOUBLE_EQ(0, standardizer.transform(2.5));
+    EXPECT_DOUBLE_EQ(1.5 / std::sqrt(1.25), standardizer.transform(4));
+}
+
+TEST(standardizer, stable_with_large_offset) {
+    Standardizer<double> standardizer;
+    for (int i = 0; i < 1000; i++) {
+        standardizer.step(1e9 + (i % 2));
+    }
+    standardizer.finalize();
+    EXPECT_NEAR(0.25, standardizer.moments().m2 / 1000, 1e-9);
+    EXPECT_NEAR(1, standardizer.transform(1e9 + 1), 1e-6);
+}
+
+TEST(standardizer, merged_shards_match_single_fit) {
+    Standardizer<double> whole, left, right;
+    for (int i = 0; i < 100; i++) {
+        double x = std::sin(i) * 10 + i;
+        whole.step(x);
+        (i < 30 ? left : right).step(x);
+    }
+    left.merge(right);
+    EXPECT_EQ(whole.moments().count, left.moments().count);
+    EXPECT_NEAR(whole.moments().mean, left.moments().mean, 1e-12);
+    EXPECT_NEAR(whole.moments().m2, left.moments().m2, 1e-9);
+}
+
+TEST(standardizer, batch_same_on_every_level) {
+    Standardizer<double> standardizer;
+    std::vector<double> samples;
+    for (int i = 0; i < 37; i++) {
+        samples.push_back(i * 0.37 - 3);
+    }
+    standardizer.step_batch(samples);
+    standardizer.finalize();
+
+    std::vector<double> expected;
+    for (double x : samples) {
+        expected.push_back(standardizer.transform(x));
+    }
+    simd::Level detected = simd::detect_level();
+    for (int level = 0; level <= static_cast<int>(detected); level++) {
+        simd::set_level(static_cast<simd::Level>(level));
+        EXPECT_EQ(expected, standardizer.transform_batch(samples));
+    }
+    simd::set_level(detected);
+}
+
+TEST(standardizer, vector) {
+    Standardizer<std::vector<double>> standardizer;
+    standardizer.step({1, 5, 7});
+    standardizer.step({3, 5, 9});
+    standardizer.finalize();
+    EXPECT_EQ(std::vector<double>({-1, 0, 1}),
+            standardizer.transform({1, 5, 9}));
+    EXPECT_THROW(standardizer.transform({1, 2}), std::invalid_argument);
+
+    standardizer.extend();
+    standardizer.step({2, 5, 11});
+    standardizer.finalize();
+    EXPECT_DOUBLE_EQ(0, standardizer.transform({2, 5, 9})[0]);
+}
+
+TEST(standardizer, float_vector) {
+    std::vector<std::vector<double>> samples;
+    std::vector<std::vector<float>> float_samples;
+    for (int i = 0; i < 100; i++) {
+        std::vector<double> sample;
+        for (int j = 0; j < 37; j++) {
+            sample.push_back((i * 7 + j * 13) % 23 * 0.5);
+        }
+        samples.push_back(sample);
+        float_samples.emplace_back(sample.begin(), sample.end());
+    }
+    Standardizer<std::vector<double>> standardizer;
+    Standardizer<std::vector<float>> float_standardizer;
+    standardizer.step_batch(samples);
+    float_standardizer.step_batch(float_samples);
+    standardizer.finalize();
+    float_standardizer.finalize();
+    EXPECT_EQ(37, float_standardizer.output_dim());
+
+    simd::Level detected = simd::detect_level();
+    for (int level = 0; level <= static_cast<int>(detected); level++) {
+        simd::set_level(static_cast<simd::Level>(level));
+        for (size_t i = 0; i < samples.size(); i += 9) {
+            std::vector<double> expected = standardizer.transform(samples[i]);
+            std::vector<float> output =
+                float_standardizer.transform(float_samples[i]);
+            ASSERT_EQ(expected.size(), output.size());
+            for (size_t j = 0; j < output.size(); j++) {
+                EXPECT_NEAR(expected[j], output[j], 1e-5);
+            }
+        }
+    }
+    simd::set_level(detected);
+}
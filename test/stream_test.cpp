@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "stream.hpp"
+#include "text.hpp"
+
+using transformer::Lowercase;
+using transformer::SpscQueue;
+using transformer::TransformFunc;
+using transformer::make_lazy_transformer;
+using transformer::make_stream;
+using transformer::make_transformer;
+
+TEST(spsc_queue, bounded_and_ordered) {
+    SpscQueue<int> queue(3);
+    EXPECT_EQ(4, queue.capacity());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_push(std::move(i)));
+    }
+    int value = 4;
+    EXPECT_FALSE(queue.try_push(std::move(value)));
+
+    std::thread producer([&queue]() {
+        for (int i = 4; i < 1000; i++) {
+            queue.push(std::move(i));
+        }
+        queue.close();
+    });
+    int expected = 0;
+    while (queue.pop(value)) {
+        EXPECT_EQ(expected++, value);
+    }
+    producer.join();
+    EXPECT_EQ(1000, expected);
+}
+
+TEST(stream, runs_stages_in_order) {
+    TransformFunc<int, int> add_one = [](const int& x) -> int {
+        return x + 1;
+    };
+    TransformFunc<int, int> twice = [](const int& x) -> int {
+        return x * 2;
+    };
+    TransformFunc<int, std::string> to_string = [](const int& x) -> std::string {
+        return std::to_string(x);
+    };
+    auto stream = make_stream(make_lazy_transformer(add_one) +
+            make_lazy_transformer(twice), 2)
+        .then(make_lazy_transformer(add_one))
+        .then(make_lazy_transformer(to_string));
+
+    int next = 0;
+    std::vector<std::string> output;
+    stream.run([&next](std::vector<int>& batch) {
+        for (int i = 0; i < 7 && next < 100; i++) {
+            batch.push_back(next++);
+        }
+        return !batch.empty();
+    }, [&output](std::vector<std::string>&& batch) {
+        output.insert(output.end(), batch.begin(), batch.end());
+    });
+
+    ASSERT_EQ(100, output.size());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(std::to_string((i + 1) * 2 + 1), output[i]);
+    }
+}
+
+TEST(stream, rethrows_stage_error) {
+    TransformFunc<int, int> fail_on_50 = [](const int& x) -> int {
+        if (x == 50) {
+            throw std::runtime_error("bad sample");
+        }
+        return x;
+    };
+    auto stream = make_stream(make_lazy_transformer(fail_on_50), 1);
+    int next = 0;
+    EXPECT_THROW(stream.run([&next](std::vector<int>& batch) {
+        batch.push_back(next++);
+        return true;
+    }, [](std::vector<int>&&) {}), std::runtime_error);
+}
+
+TEST(stream, stages_transform_batches_in_place) {
+    // Each batch comes out of the Lowercase stage in the buffer it went in.
+    std::mutex mutex;
+    std::vector<const std::string*> buffers;
+    int next = 0;
+    size_t batches = 0;
+    std::vector<std::string> output;
+    make_stream(make_transformer<Lowercase>(), 2).run(
+            [&](std::vector<std::string>& batch) {
+        for (int i = 0; i < 5 && next < 50; i++) {
+            batch.push_back("ITEM " + std::to_string(next++));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(batch.data());
+        return !batch.empty();
+    }, [&](std::vector<std::string>&& batch) {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(buffers[batches++], batch.data());
+        output.insert(output.end(), batch.begin(), batch.end());
+    });
+    EXPECT_EQ(10, batches);
+    ASSERT_EQ(50, output.size());
+    EXPECT_EQ("item 49", output[49]);
+}
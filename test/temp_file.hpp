@@ -0,0 +1,40 @@
+/**
+ * Files for the tests to read and write, with unique names (mkstemp) so
+ * that concurrent test runs don't clash.
+ */
+#ifndef FASTFEA_TEMP_FILE_H
+#define FASTFEA_TEMP_FILE_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+// A file removed when the test is done.
+class TempFile {
+public:
+    explicit TempFile(const std::string& content = "") {
+        char path[] = "/tmp/fastfea_test_XXXXXX";
+        int fd = mkstemp(path);
+        ::close(fd);
+        _path = path;
+        std::ofstream(_path, std::ios::binary) << content;
+    }
+
+    ~TempFile() {
+        std::remove(_path.c_str());
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    const std::string& path() const {
+        return _path;
+    }
+
+private:
+    std::string _path;
+};
+
+#endif
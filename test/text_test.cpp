@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "text.hpp"
+
+using transformer::FeatureHasher;
+using transformer::FeatureValue;
+using transformer::Lowercase;
+using transformer::MultiHotBinarizer;
+using transformer::NGram;
+using transformer::StringView;
+using transformer::Tokenizer;
+using transformer::make_lazy_transformer;
+using transformer::make_transformer;
+namespace simd = transformer::simd;
+
+namespace {
+
+struct Document {
+    std::string text;
+};
+
+std::vector<std::string> strings(const std::vector<StringView>& views) {
+    std::vector<std::string> output;
+    for (const auto& view : views) {
+        output.push_back(view.str());
+    }
+    return output;
+}
+}
+
+TEST(text, tokenizer_views_into_text) {
+    std::string text = "  the quick\tbrown  fox\njumps over the lazy dog, "
+        "the end ";
+    simd::Level detected = simd::detect_level();
+    for (int level = 0; level <= static_cast<int>(detected); level++) {
+        simd::set_level(static_cast<simd::Level>(level));
+        auto tokens = Tokenizer().transform(text);
+        EXPECT_EQ(std::vector<std::string>({"the", "quick", "brown", "fox",
+                    "jumps", "over", "the", "lazy", "dog,", "the", "end"}),
+                strings(tokens));
+        EXPECT_EQ(text.data() + 2, tokens[0].data());
+        EXPECT_EQ(std::vector<std::string>({"  the quick\\tbrown  fox\\njumps "
+                    "over the lazy dog", " the end "}),
+                strings(Tokenizer(",").transform(
+                        "  the quick\\tbrown  fox\\njumps over the lazy dog, "
+                        "the end ")));
+    }
+    EXPECT_TRUE(Tokenizer().transform("").empty());
+    EXPECT_TRUE(Tokenizer().transform(" \n ").empty());
+}
+
+TEST(text, ngram_hashes) {
+    NGram<std::vector<StringView>> bigrams(1, 2);
+    auto hashes = bigrams.transform(Tokenizer().transform("a b a b"));
+    // a, ab, b, ba, a, ab, b
+    ASSERT_EQ(7, hashes.size());
+    EXPECT_EQ(hashes[0], hashes[4]);
+    EXPECT_EQ(hashes[1], hashes[5]);
+    EXPECT_NE(hashes[1], hashes[3]);
+    EXPECT_NE(hashes[0], hashes[2]);
+
+    NGram<StringView> trigrams(3, 3);
+    auto chars = trigrams.transform("abcabc");
+    ASSERT_EQ(4, chars.size());
+    EXPECT_EQ(chars[0], chars[3]);
+    EXPECT_NE(chars[0], chars[1]);
+    EXPECT_TRUE(trigrams.transform("ab").empty());
+}
+
+TEST(text, bag_of_words_pipeline) {
+    auto text = make_lazy_transformer<Document, StringView>(
+            [](const Document& doc) { return StringView(doc.text); });
+    auto words = text + make_transformer<Tokenizer>() +
+        make_transformer<NGram<std::vector<StringView>>>(1, 1);
+    auto hashed = words + make_transformer<FeatureHasher>(1 << 10);
+    auto bag = hashed->transform(Document{"to be or not to be"});
+    EXPECT_EQ(1 << 10, bag.dim);
+    double total = 0;
+    for (double count : bag.values) {
+        total += count;
+    }
+    EXPECT_EQ(6, total);
+    EXPECT_LE(bag.nnz(), 4);
+
+    auto vocabulary = words + make_transformer<MultiHotBinarizer<uint64_t>>();
+    vocabulary->step_batch({Document{"to be"}, Document{"or not to be"}});
+    vocabulary->finalize();
+    EXPECT_EQ(std::vector<FeatureValue>({1, 1, 0, 0}),
+            vocabulary->transform(Document{"be to unseen"}));
+    EXPECT_EQ(std::vector<FeatureValue>({0, 0, 1, 1}),
+            vocabulary->transform(Document{"not or"}));
+}
+
+TEST(text, lowercase_in_place) {
+    auto lower = make_transformer<Lowercase>() + make_transformer<Lowercase>();
+    std::string text("Some Text, Long Enough To Live On The Heap");
+    EXPECT_EQ("some text, long enough to live on the heap",
+            lower->transform(text));
+    EXPECT_EQ("Some Text, Long Enough To Live On The Heap", text);
+
+    // Both stages lower the caller's string where it is.
+    const char* data = text.data();
+    std::string output = lower->transform(std::move(text));
+    EXPECT_EQ(data, output.data());
+    EXPECT_EQ("some text, long enough to live on the heap", output);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include "text.hpp"
+#include "tfidf.hpp"
+
+using transformer::CountMinSketch;
+using transformer::Counting;
+using transformer::NGram;
+using transformer::StringView;
+using transformer::TfIdf;
+using transformer::Tokenizer;
+using transformer::make_transformer;
+
+namespace {
+
+std::vector<uint64_t> words(const std::string& text) {
+    return NGram<std::vector<StringView>>(1, 1).transform(
+            Tokenizer().transform(text));
+}
+}
+
+TEST(count_min_sketch, never_underestimates) {
+    CountMinSketch sketch(256, 4);
+    CountMinSketch shard(256, 4);
+    for (uint64_t i = 0; i < 5000; i++) {
+        (i % 2 ? sketch : shard).add(i % 500, i % 500 == 7 ? 100 : 1);
+    }
+    sketch.merge(shard);
+    EXPECT_GE(sketch.count(7), 1000);
+    EXPECT_LT(sketch.count(7), 1100);
+    for (uint64_t key = 0; key < 500; key++) {
+        EXPECT_GE(sketch.count(key), 10);
+    }
+    EXPECT_THROW(sketch.merge(CountMinSketch(512, 4)), std::invalid_argument);
+}
+
+TEST(tfidf, weights_rare_terms_up) {
+    for (auto counting : {Counting::Exact, Counting::Sketch}) {
+        TfIdf tfidf(1 << 16, counting, 1 << 12);
+        TfIdf shard(1 << 16, counting, 1 << 12);
+        tfidf.step(words("the cat sat"));
+        tfidf.step(words("the dog sat"));
+        shard.step(words("the cat ran"));
+        shard.step(words("the end"));
+        tfidf.merge(shard);
+        tfidf.finalize();
+        EXPECT_EQ(4, tfidf.num_docs());
+
+        uint64_t the = words("the")[0];
+        uint64_t dog = words("dog")[0];
+        EXPECT_DOUBLE_EQ(std::log(5.0 / 5) + 1, tfidf.term_idf(the));
+        EXPECT_DOUBLE_EQ(std::log(5.0 / 2) + 1, tfidf.term_idf(dog));
+        EXPECT_DOUBLE_EQ(std::log(5.0) + 1,
+                tfidf.term_idf(words("unicorn")[0]));
+
+        auto out = tfidf.transform(words("the dog the"));
+        ASSERT_EQ(2, out.nnz());
+        double the_weight = out.values[out.indices[0] == the % (1 << 16) ?
+            0 : 1];
+        double dog_weight = out.values[out.indices[0] == the % (1 << 16) ?
+            1 : 0];
+        EXPECT_NEAR(2 / (std::log(2.5) + 1), the_weight / dog_weight, 1e-12);
+        EXPECT_NEAR(1, the_weight * the_weight + dog_weight * dog_weight,
+                1e-12);
+    }
+}
@@ -1,12 +1,76 @@
 #include <gtest/gtest.h>
 #include <string>
 
+#include "sparse.hpp"
 #include "transformer.hpp"
 
+using transformer::Binarizer;
+using transformer::FeatureValue;
 using transformer::Transformer;
 using transformer::make_lazy_transformer;
+using transformer::make_transformer;
 using transformer::TransformFunc;
 
+namespace {
+
+// Counts its copies, to check that rvalues are moved along.
+struct Tracked {
+    static int copies;
+    std::string value;
+
+    explicit Tracked(const std::string& value) : value(value) {}
+    Tracked(const Tracked& other) : value(other.value) {
+        copies++;
+    }
+    Tracked(Tracked&&) = default;
+    Tracked& operator=(const Tracked& other) {
+        value = other.value;
+        copies++;
+        return *this;
+    }
+    Tracked& operator=(Tracked&&) = default;
+};
+
+int Tracked::copies = 0;
+
+// Fitted identity, to have the pipeline buffer samples.
+class TrackedIdentity : public Transformer<Tracked, Tracked> {
+public:
+    TrackedIdentity() { this->_is_finalized = false; }
+
+    virtual void finalize() {
+        this->_is_finalized = true;
+    }
+
+    virtual Tracked transform(const Tracked& sample) const {
+        return sample;
+    }
+
+    virtual Tracked transform(Tracked&& sample) {
+        return std::move(sample);
+    }
+};
+
+class TrackedLength : public Transformer<Tracked, size_t> {
+public:
+    TrackedLength() { this->_is_finalized = false; }
+
+    virtual void step(const Tracked& sample) {
+        total += sample.value.size();
+    }
+
+    virtual void finalize() {
+        this->_is_finalized = true;
+    }
+
+    virtual size_t transform(const Tracked& sample) const {
+        return sample.value.size();
+    }
+
+    size_t total = 0;
+};
+}
+
 // Simple data for testing
 struct Data {
     std::string firstname;
@@ -107,4 +171,101 @@ TEST(combiner, combine_vector) {
     // Actually all we want is compiler to pass.
     auto v3 = transformer::combine(std::move(v1), std::move(v2));
     EXPECT_EQ(2, v3.size());
-}
\ No newline at end of file
+}
+
+TEST(combiner, combine_sparse_vector) {
+    transformer::SparseVector<double> s1(3);
+    s1.push_back(1, 2.0);
+    transformer::SparseVector<double> s2(2);
+    s2.push_back(0, 3.0);
+    auto s3 = transformer::combine(std::move(s1), std::move(s2));
+    EXPECT_EQ(std::vector<double>({0, 2, 0, 3, 0}), s3.to_dense());
+}
+
+TEST(transformer, extend_keeps_fitted_indices) {
+    auto firstname = make_lazy_data_transformer(firstname_lambda);
+    auto lastname = make_lazy_data_transformer(lastname_lambda);
+    auto pipe = (firstname | lastname) +
+        make_transformer<Binarizer<std::tuple<std::string, std::string>>>();
+
+    Data mike{"Mike", "Jordan"};
+    Data bill{"Bill", "Jordan"};
+    pipe->step(mike);
+    pipe->step(bill);
+    pipe->finalize();
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1}), pipe->transform(bill));
+
+    // Steps are ignored until the pipeline is reopened.
+    Data anna{"Anna", "Smith"};
+    pipe->step(anna);
+    pipe->finalize();
+    EXPECT_EQ(2, pipe->transform(mike).size());
+
+    pipe->extend();
+    EXPECT_FALSE(pipe->is_finalized());
+    pipe->step(anna);
+    pipe->step(mike);
+    pipe->finalize();
+    EXPECT_EQ(std::vector<FeatureValue>({1, 0, 0}), pipe->transform(mike));
+    EXPECT_EQ(std::vector<FeatureValue>({0, 1, 0}), pipe->transform(bill));
+    EXPECT_EQ(std::vector<FeatureValue>({0, 0, 1}), pipe->transform(anna));
+}
+
+TEST(transformer, output_dim) {
+    auto firstname = make_lazy_data_transformer(firstname_lambda) +
+        make_transformer<Binarizer<std::string>>();
+    auto lastname = make_lazy_data_transformer(lastname_lambda) +
+        make_transformer<Binarizer<std::string>>();
+    auto both = firstname | lastname;
+    EXPECT_EQ(0, make_lazy_data_transformer(firstname_lambda)->output_dim());
+
+    both->step(Data{"Mike", "Jordan"});
+    both->step(Data{"Bill", "Jordan"});
+    both->finalize();
+    EXPECT_EQ(2, firstname->output_dim());
+    EXPECT_EQ(1, lastname->output_dim());
+    EXPECT_EQ(3, both->output_dim());
+    EXPECT_EQ(both->output_dim(), both->transform(Data{"Mike", "Jordan"}).size());
+    EXPECT_EQ(0, (both | make_lazy_data_transformer(lastname_lambda))
+            ->output_dim());
+}
+
+TEST(transformer, binarizer_value_type) {
+    auto firstname = make_lazy_data_transformer(firstname_lambda) +
+        make_transformer<Binarizer<std::string, uint8_t>>();
+    auto lastname = make_lazy_data_transformer(lastname_lambda) +
+        make_transformer<Binarizer<std::string, float>>();
+    auto both = firstname | lastname;
+    both->step(Data{"Mike", "Jordan"});
+    both->step(Data{"Bill", "Smith"});
+    both->finalize();
+
+    EXPECT_EQ(std::vector<uint8_t>({0, 1}),
+            firstname->transform(Data{"Bill", "Smith"}));
+    // uint8_t and float codes combine as float.
+    std::vector<float> out = both->transform(Data{"Bill", "Jordan"});
+    EXPECT_EQ(std::vector<float>({0, 1, 1, 0}), out);
+}
+
+TEST(transformer, rvalues_are_moved_through_pipeline) {
+    auto length = std::make_shared<TrackedLength>();
+    auto identity = std::make_shared<TrackedIdentity>();
+    std::shared_ptr<Transformer<Tracked, Tracked>> first = identity;
+    std::shared_ptr<Transformer<Tracked, size_t>> second = length;
+    auto pipe = first + second;
+
+    Tracked::copies = 0;
+    pipe->step(Tracked("abc"));
+    pipe->step(Tracked("de"));
+    pipe->finalize();
+    EXPECT_EQ(5, length->total);
+    EXPECT_EQ(3, pipe->transform(Tracked("xyz")));
+    EXPECT_EQ(0, Tracked::copies);
+
+    // The first branch of a combiner reads the sample as it is, only the
+    // second one may take it.
+    auto both = pipe | pipe;
+    EXPECT_EQ(std::make_tuple(size_t(2), size_t(2)),
+            both->transform(Tracked("ab")));
+    EXPECT_EQ(1, Tracked::copies);
+}
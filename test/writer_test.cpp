@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dense_writer.hpp"
+#include "standardizer.hpp"
+#include "temp_file.hpp"
+#include "writer.hpp"
+
+using transformer::CsrWriter;
+using transformer::DenseMatrixWriter;
+using transformer::LibSvmWriter;
+using transformer::SparseVector;
+using transformer::Standardizer;
+using transformer::Transformer;
+using transformer::format_shortest;
+
+namespace {
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+std::string format(double value) {
+    char out[32];
+    return std::string(out, format_shortest(value, out));
+}
+
+std::string format_float(float value) {
+    char out[32];
+    return std::string(out, format_shortest(value, out));
+}
+
+// Doubles its input, and records the slices it's asked to transform.
+class SliceRecorder : public Transformer<double, double> {
+public:
+    virtual double transform(const double& sample) const {
+        return sample * 2;
+    }
+
+    using Transformer<double, double>::transform_batch;
+
+    virtual std::vector<double> transform_batch(const double* first,
+            size_t n) const {
+        slices.emplace_back(first, n);
+        return Transformer<double, double>::transform_batch(first, n);
+    }
+
+    mutable std::vector<std::pair<const double*, size_t>> slices;
+};
+}
+
+TEST(writer, shortest_round_trip_formatting) {
+    EXPECT_EQ("1", format(1));
+    EXPECT_EQ("-3", format(-3));
+    EXPECT_EQ("0", format(0));
+    EXPECT_EQ("-0", format(-0.0));
+    EXPECT_EQ("0.1", format(0.1));
+    EXPECT_EQ("0.30000000000000004", format(0.1 + 0.2));
+    EXPECT_EQ("1e+20", format(1e20));
+    EXPECT_EQ("2.5e-300", format(2.5e-300));
+    EXPECT_EQ("5e-324", format(5e-324));
+    std::mt19937_64 rng(3);
+    for (int i = 0; i < 10000; i++) {
+        uint64_t bits = rng();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (std::isnan(value)) {
+            continue;
+        }
+        EXPECT_EQ(value, std::strtod(format(value).c_str(), nullptr));
+    }
+}
+
+TEST(writer, shortest_float_formatting) {
+    EXPECT_EQ("0.1", format_float(0.1f));
+    EXPECT_EQ("-2", format_float(-2.0f));
+    EXPECT_EQ("16777216", format_float(16777216.0f));
+    EXPECT_EQ("3.4028235e+38", format_float(FLT_MAX));
+    EXPECT_EQ("1e-45", format_float(1e-45f));
+    std::mt19937 rng(5);
+    for (int i = 0; i < 10000; i++) {
+        uint32_t bits = rng();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (std::isnan(value)) {
+            continue;
+        }
+        std::string text = format_float(value);
+        EXPECT_EQ(value, std::strtof(text.c_str(), nullptr));
+        // Never longer than the 9 digits a float may need.
+        EXPECT_LE(text.size(), 15u);
+    }
+
+    TempFile file;
+    LibSvmWriter writer(file.path());
+    writer.write(std::vector<float>({0.1f, 0, 2.5f}), 1);
+    writer.close();
+    EXPECT_EQ("1 1:0.1 3:2.5\n", read_file(file.path()));
+}
+
+TEST(writer, libsvm_dense_and_sparse) {
+    TempFile file;
+    const std::string& path = file.path();
+    {
+        LibSvmWriter writer(path);
+        writer.write_batch(std::vector<std::vector<double>>({{0, 1, 0, 0.5},
+                    {0, 0, 0, 0}}), {1, 0});
+        SparseVector<double> row(100);
+        row.push_back(9, -2.25);
+        row.push_back(99, 1);
+        writer.write(row, -1);
+        writer.close();
+    }
+    EXPECT_EQ("1 2:1 4:0.5\n0\n-1 10:-2.25 100:1\n", read_file(path));
+    {
+        LibSvmWriter writer(path, 0);
+        writer.write(std::vector<double>({3, 0}));
+    }
+    EXPECT_EQ("0 0:3\n", read_file(path));
+}
+
+TEST(writer, csr_binary) {
+    TempFile file;
+    const std::string& path = file.path();
+    {
+        CsrWriter writer(path);
+        SparseVector<double> row(10);
+        row.push_back(2, 1.5);
+        row.push_back(7, -1);
+        writer.write(row);
+        writer.write(SparseVector<double>(10));
+        writer.write_batch(std::vector<std::vector<double>>({{0, 4, 0}}));
+        writer.close();
+    }
+    std::string content = read_file(path);
+    ASSERT_GE(content.size(), 64);
+    EXPECT_EQ("FFCSR001", content.substr(0, 8));
+    uint64_t header[7];
+    std::memcpy(header, content.data(), sizeof(header));
+    EXPECT_EQ(3, header[1]);
+    EXPECT_EQ(10, header[2]);
+    EXPECT_EQ(3, header[3]);
+    uint64_t indptr[4];
+    std::memcpy(indptr, content.data() + header[4], sizeof(indptr));
+    EXPECT_EQ(0, indptr[0]);
+    EXPECT_EQ(2, indptr[1]);
+    EXPECT_EQ(2, indptr[2]);
+    EXPECT_EQ(3, indptr[3]);
+    uint32_t indices[3];
+    std::memcpy(indices, content.data() + header[5], sizeof(indices));
+    EXPECT_EQ(std::vector<uint32_t>({2, 7, 1}),
+            std::vector<uint32_t>(indices, indices + 3));
+    double values[3];
+    EXPECT_EQ(0, header[6] % 8);
+    std::memcpy(values, content.data() + header[6], sizeof(values));
+    EXPECT_EQ(std::vector<double>({1.5, -1, 4}),
+            std::vector<double>(values, values + 3));
+    EXPECT_EQ(header[4] + sizeof(indptr), content.size());
+    std::ifstream tmp(path + ".values.tmp");
+    EXPECT_FALSE(tmp.good());
+}
+
+TEST(writer, dense_npy) {
+    TempFile file;
+    const std::string& path = file.path();
+    {
+        DenseMatrixWriter<> writer(path, 3, 2);
+        writer.write_row(0, std::vector<double>{1, 2});
+        SparseVector<double> sparse(2);
+        sparse.push_back(1, -0.5);
+        writer.write_row(2, sparse);
+        EXPECT_THROW(writer.write_row(1, std::vector<double>{1}),
+                std::invalid_argument);
+        EXPECT_THROW(writer.write_row(3, std::vector<double>{1, 2}),
+                std::invalid_argument);
+        writer.close();
+    }
+    std::string content = read_file(path);
+    EXPECT_EQ(std::string("\x93NUMPY\x01\x00", 8), content.substr(0, 8));
+    size_t header_size = 10 + (static_cast<unsigned char>(content[8]) |
+            static_cast<unsigned char>(content[9]) << 8);
+    EXPECT_EQ(0u, header_size % 64);
+    ASSERT_EQ(header_size + 6 * sizeof(float), content.size());
+    std::string dict = content.substr(10, header_size - 10);
+    EXPECT_EQ(0u, dict.find(
+                "{'descr': '<f4', 'fortran_order': False, 'shape': (3, 2), }"));
+    EXPECT_EQ('\n', dict.back());
+    float values[6];
+    std::memcpy(values, content.data() + header_size, sizeof(values));
+    float expected[6] = {1, 2, 0, 0, 0, -0.5};
+    for (size_t i = 0; i < 6; i++) {
+        EXPECT_EQ(expected[i], values[i]);
+    }
+}
+
+TEST(writer, dense_transform_into_raw) {
+    std::vector<std::vector<double>> samples;
+    for (size_t i = 0; i < 5000; i++) {
+        samples.push_back({static_cast<double>(i), i * 0.5, 1.0 * (i % 7)});
+    }
+    Standardizer<std::vector<double>> standardizer;
+    standardizer.step_batch(samples);
+    standardizer.finalize();
+
+    TempFile file;
+    const std::string& path = file.path();
+    {
+        DenseMatrixWriter<> writer(path, samples.size() + 1, 3,
+                DenseMatrixWriter<>::Raw);
+        writer.transform_into(standardizer, samples, 1, 4);
+        EXPECT_THROW(writer.transform_into(standardizer, samples, 2),
+                std::invalid_argument);
+        writer.close();
+    }
+    std::string content = read_file(path);
+    ASSERT_EQ((samples.size() + 1) * 3 * sizeof(float), content.size());
+    std::vector<float> values(content.size() / sizeof(float));
+    std::memcpy(values.data(), content.data(), content.size());
+    EXPECT_EQ(0, values[0]);
+    for (size_t i = 0; i < samples.size(); i += 997) {
+        std::vector<double> row = standardizer.transform(samples[i]);
+        for (size_t j = 0; j < 3; j++) {
+            EXPECT_EQ(static_cast<float>(row[j]), values[(i + 1) * 3 + j]);
+        }
+    }
+}
+
+TEST(writer, dense_transform_into_batches_slices_of_samples) {
+    std::vector<double> samples(2500);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = static_cast<double>(i);
+    }
+    SliceRecorder recorder;
+    TempFile file;
+    const std::string& path = file.path();
+    {
+        DenseMatrixWriter<> writer(path, samples.size(), 1,
+                DenseMatrixWriter<>::Raw);
+        writer.transform_into(recorder, samples);
+        writer.close();
+    }
+    // Batches of 1024, pointing into samples rather than copies of them.
+    const double* data = samples.data();
+    std::vector<std::pair<const double*, size_t>> expected = {
+        {data, 1024}, {data + 1024, 1024}, {data + 2048, 452}};
+    EXPECT_EQ(expected, recorder.slices);
+
+    std::string content = read_file(path);
+    ASSERT_EQ(samples.size() * sizeof(float), content.size());
+    std::vector<float> values(samples.size());
+    std::memcpy(values.data(), content.data(), content.size());
+    for (size_t i = 0; i < samples.size(); i += 499) {
+        EXPECT_EQ(2.0f * i, values[i]);
+    }
+}